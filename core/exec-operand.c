@@ -9,6 +9,7 @@
 #include "libc.h"
 #include "ns_impl.h"
 #include "opregion.h"
+#include "util-bits.h"
 
 size_t lai_exec_string_length(lai_variable_t *str) {
     LAI_ENSURE(str->type == LAI_STRING);
@@ -17,11 +18,31 @@ size_t lai_exec_string_length(lai_variable_t *str) {
 
 // Note: This function exists to enable better GC and proper locking in the future.
 void lai_exec_pkg_var_load(lai_variable_t *out, struct lai_pkg_head *head, size_t i) {
+    if (head->packed) {
+        lai_variable_t elem = {.type = LAI_INTEGER, .integer = head->packed_elems[i]};
+        lai_var_move(out, &elem);
+        return;
+    }
+
+    // The caller might modify the element through the returned reference.
+    // Make sure that this does not affect other packages that share the elements.
+    int type = head->elems[i].type;
+    if ((type == LAI_STRING || type == LAI_BUFFER || type == LAI_PACKAGE)
+        && head->storage->rc > 1)
+        lai_exec_pkg_unshare(head);
     lai_var_assign(out, &head->elems[i]);
 }
 
 // Note: This function exists to enable better GC and proper locking in the future.
 void lai_exec_pkg_var_store(lai_variable_t *in, struct lai_pkg_head *head, size_t i) {
+    if (head->packed && in->type != LAI_INTEGER)
+        lai_exec_pkg_unpack(head);
+    if (head->storage->rc > 1)
+        lai_exec_pkg_unshare(head);
+    if (head->packed) {
+        head->packed_elems[i] = in->integer;
+        return;
+    }
     lai_var_assign(&head->elems[i], in);
 }
 
@@ -74,6 +95,7 @@ void lai_exec_ref_store(lai_variable_t *ref, lai_variable_t *object) {
 void lai_exec_access(lai_variable_t *object, lai_nsnode_t *src) {
     switch (src->type) {
         case LAI_NAMESPACE_NAME:
+            lai_exec_materialize_name(src);
             lai_var_assign(object, &src->object);
             break;
         case LAI_NAMESPACE_FIELD:
@@ -93,6 +115,7 @@ void lai_exec_access(lai_variable_t *object, lai_nsnode_t *src) {
         case LAI_NAMESPACE_DEVICE:
             object->type = LAI_HANDLE;
             object->handle = src;
+            src->referenced = 1;
             break;
         default:
             lai_panic("unexpected type %d of named object in lai_exec_access()", src->type);
@@ -133,8 +156,13 @@ void lai_operand_load(lai_state_t *state, struct lai_operand *src, lai_variable_
 }
 
 void lai_store_ns(lai_nsnode_t *target, lai_variable_t *object) {
+    lai_current_instance()->store_generation++;
     switch (target->type) {
         case LAI_NAMESPACE_NAME:
+            // The initializer of a lazy Name() is simply discarded.
+            target->name_lazy_ctx = NULL;
+            target->pointer = NULL;
+            target->size = 0;
             lai_var_assign(&target->object, object);
             break;
         case LAI_NAMESPACE_FIELD:
@@ -151,8 +179,10 @@ void lai_store_ns(lai_nsnode_t *target, lai_variable_t *object) {
 }
 
 void lai_exec_mutate_ns(lai_nsnode_t *target, lai_variable_t *object) {
+    lai_current_instance()->store_generation++;
     switch (target->type) {
         case LAI_NAMESPACE_NAME:
+            lai_exec_materialize_name(target);
             switch (target->object.type) {
                 case LAI_INTEGER:
                     if (lai_mutate_integer(&target->object, object))
@@ -200,22 +230,26 @@ void lai_exec_mutate_ns(lai_nsnode_t *target, lai_variable_t *object) {
 //                       This is the type of store used by Store() and arithmetic operators.
 void lai_operand_mutate(lai_state_t *state, struct lai_operand *dest, lai_variable_t *object) {
     // First, handle stores to AML references (returned by Index() and friends).
+    // These may modify the contents of named objects.
     if (dest->tag == LAI_OPERAND_OBJECT) {
+        lai_current_instance()->store_generation++;
         switch (dest->object.type) {
             case LAI_STRING_INDEX: {
+                lai_exec_string_unshare(dest->object.string_ptr);
                 char *window = dest->object.string_ptr->content;
-                window[dest->object.integer] = object->integer;
+                window[dest->object.index] = object->integer;
                 break;
             }
             case LAI_BUFFER_INDEX: {
+                lai_exec_buffer_unshare(dest->object.buffer_ptr);
                 uint8_t *window = dest->object.buffer_ptr->content;
-                window[dest->object.integer] = object->integer;
+                window[dest->object.index] = object->integer;
                 break;
             }
             case LAI_PACKAGE_INDEX: {
                 lai_variable_t copy = {0};
                 lai_var_assign(&copy, object);
-                lai_exec_pkg_var_store(&copy, dest->object.pkg_ptr, dest->object.integer);
+                lai_exec_pkg_var_store(&copy, dest->object.pkg_ptr, dest->object.index);
                 lai_var_finalize(&copy);
                 break;
             }
@@ -265,10 +299,10 @@ void lai_operand_mutate(lai_state_t *state, struct lai_operand *dest, lai_variab
                         lai_debug("Debug(): integer(%ld)", object->integer);
                         break;
                     case LAI_STRING:
-                        lai_debug("Debug(): string(\"%s\")", lai_exec_string_access(object));
+                        lai_debug("Debug(): string(\"%s\")", lai_exec_string_view(object));
                         break;
                     case LAI_BUFFER:
-                        lai_debug("Debug(): buffer(%lX)", (size_t)lai_exec_buffer_access(object));
+                        lai_debug("Debug(): buffer(%lX)", (size_t)lai_exec_buffer_view(object));
                         break;
                     default:
                         lai_debug("Debug(): type %d", object->type);
@@ -284,22 +318,26 @@ void lai_operand_mutate(lai_state_t *state, struct lai_operand *dest, lai_variab
 //                        This is used by CopyObject() and type conversion operators.
 void lai_operand_emplace(lai_state_t *state, struct lai_operand *dest, lai_variable_t *object) {
     // First, handle stores to AML references (returned by Index() and friends).
+    // These may modify the contents of named objects.
     if (dest->tag == LAI_OPERAND_OBJECT) {
+        lai_current_instance()->store_generation++;
         switch (dest->object.type) {
             case LAI_STRING_INDEX: {
+                lai_exec_string_unshare(dest->object.string_ptr);
                 char *window = dest->object.string_ptr->content;
-                window[dest->object.integer] = object->integer;
+                window[dest->object.index] = object->integer;
                 break;
             }
             case LAI_BUFFER_INDEX: {
+                lai_exec_buffer_unshare(dest->object.buffer_ptr);
                 uint8_t *window = dest->object.buffer_ptr->content;
-                window[dest->object.integer] = object->integer;
+                window[dest->object.index] = object->integer;
                 break;
             }
             case LAI_PACKAGE_INDEX: {
                 lai_variable_t copy = {0};
                 lai_var_assign(&copy, object);
-                lai_exec_pkg_var_store(&copy, dest->object.pkg_ptr, dest->object.integer);
+                lai_exec_pkg_var_store(&copy, dest->object.pkg_ptr, dest->object.index);
                 lai_var_finalize(&copy);
                 break;
             }
@@ -349,10 +387,10 @@ void lai_operand_emplace(lai_state_t *state, struct lai_operand *dest, lai_varia
                         lai_debug("Debug(): integer(%ld)", object->integer);
                         break;
                     case LAI_STRING:
-                        lai_debug("Debug(): string(\"%s\")", lai_exec_string_access(object));
+                        lai_debug("Debug(): string(\"%s\")", lai_exec_string_view(object));
                         break;
                     case LAI_BUFFER:
-                        lai_debug("Debug(): buffer(%lX)", (size_t)lai_exec_buffer_access(object));
+                        lai_debug("Debug(): buffer(%lX)", (size_t)lai_exec_buffer_view(object));
                         break;
                     default:
                         lai_debug("Debug(): type %d", object->type);
@@ -394,53 +432,17 @@ lai_api_error_t lai_exec_get_integer(lai_state_t *state, struct lai_operand *src
 
 // lai_write_buffer(): Writes to a BufferField.
 static void lai_write_buffer(lai_nsnode_t *handle, lai_variable_t *source) {
-    uint64_t value = source->integer;
-
-    // Offset that we are writing to, in bytes.
-    size_t offset = handle->bf_offset;
-    size_t size = handle->bf_size;
-    uint8_t *data = handle->bf_buffer->content;
-
-    size_t n = 0; // Number of bits that have been written.
-    while (n < size) {
-        // First bit (of the current byte) that will be overwritten.
-        int bit = (offset + n) & 7;
-
-        // Number of bits (of the current byte) that will be overwritten.
-        int m = size - n;
-        if (m > (8 - bit))
-            m = 8 - bit;
-        LAI_ENSURE(m); // Write at least one bit.
-
-        uint8_t mask = (1 << m) - 1;
-        data[(offset + n) >> 3] &= ~(mask << bit);
-        data[(offset + n) >> 3] |= ((value >> n) & mask) << bit;
-
-        n += m;
-    }
+    // Fields that are wider than an integer only receive its low 64 bits.
+    size_t size = LAI_MIN(handle->bf_size, 64);
+    lai_exec_buffer_unshare(handle->bf_buffer);
+    lai_bits_put(handle->bf_buffer->content, handle->bf_buffer->size, handle->bf_offset, size,
+                 source->integer);
 }
 
 // lai_read_buffer(): Reads from a BufferField.
 static void lai_read_buffer(lai_variable_t *dest, lai_nsnode_t *handle) {
-    size_t offset = handle->bf_offset;
-    size_t size = handle->bf_size;
-    uint8_t *data = handle->bf_buffer->content;
-
+    size_t size = LAI_MIN(handle->bf_size, 64);
     dest->type = LAI_INTEGER;
-    dest->integer = 0;
-
-    size_t n = 0;
-    while (n < size) {
-        int bit = (offset + n) & 7;
-        int m = size - n;
-        if (m > (8 - bit))
-            m = 8 - bit;
-        LAI_ENSURE(m); // read at least one bit.
-        uint8_t mask = (1 << m) - 1;
-        uint8_t cur_byte = data[(offset + n) >> 3];
-        uint8_t to_write = ((cur_byte & mask));
-
-        dest->integer |= (uint64_t)to_write << n;
-        n += m;
-    }
+    dest->integer = lai_bits_get(handle->bf_buffer->content, handle->bf_buffer->size,
+                                 handle->bf_offset, size);
 }
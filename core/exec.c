@@ -8,10 +8,17 @@
 #include "aml_opcodes.h"
 #include "eval.h"
 #include "exec_impl.h"
+#include "ir.h"
 #include "libc.h"
+#include "memo.h"
 #include "ns_impl.h"
+#include "opregion.h"
+#include "ops.h"
+#include "profile.h"
+#include "trace.h"
 #include "util-list.h"
 #include "util-macros.h"
+#include "verify.h"
 
 static int debug_stack = 0;
 
@@ -57,10 +64,49 @@ void lai_finalize_state(lai_state_t *state) {
         laihost_free(state->opstack_base, state->opstack_capacity * sizeof(struct lai_operand));
 }
 
+// Installs a node that was created by AML. Leaf objects that a method creates in its own scope
+// only become visible to the invocation (see lai_ns_enter_invocation()). Other nodes that are
+// created by methods are installed globally and removed again once the method returns.
+static lai_api_error_t lai_exec_install_nsnode(struct lai_invocation *invocation,
+                                               lai_nsnode_t *node) {
+    if (!invocation)
+        return lai_install_nsnode(node);
+
+    if (node->parent == invocation->local_scope) {
+        switch (node->type) {
+            case LAI_NAMESPACE_NAME:
+            case LAI_NAMESPACE_ALIAS:
+            case LAI_NAMESPACE_FIELD:
+            case LAI_NAMESPACE_INDEXFIELD:
+            case LAI_NAMESPACE_BANKFIELD:
+            case LAI_NAMESPACE_BUFFER_FIELD:
+            case LAI_NAMESPACE_OPREGION:
+            case LAI_NAMESPACE_MUTEX:
+            case LAI_NAMESPACE_EVENT:
+                return lai_ns_install_local(invocation, node);
+        }
+    }
+
+    LAI_TRY(lai_install_nsnode(node));
+    lai_list_link(&invocation->per_method_list, &node->per_method_item);
+    return LAI_ERROR_NONE;
+}
+
+// Returns true if the code runs on behalf of a method (and not as part of a table load).
+// Scopes within methods, e.g., Device() bodies, do not have an invocation of their own.
+static int lai_exec_in_method(lai_state_t *state) {
+    for (int i = state->ctxstack_ptr; i >= 0; i--) {
+        if (state->ctxstack_base[i].invocation)
+            return 1;
+    }
+    return 0;
+}
+
 static lai_api_error_t lai_exec_reduce_node(int opcode, lai_state_t *state,
                                             struct lai_operand *operands,
                                             lai_nsnode_t *ctx_handle) {
-    if (lai_current_instance()->trace & LAI_TRACE_OP)
+    if ((lai_current_instance()->trace & LAI_TRACE_OP)
+        && !lai_trace_emit(LAI_TRACE_EVENT_REDUCE, opcode, 0, NULL, 0))
         lai_debug("lai_exec_reduce_node: opcode 0x%02X", opcode);
     switch (opcode) {
         case NAME_OP: {
@@ -75,11 +121,8 @@ static lai_api_error_t lai_exec_reduce_node(int opcode, lai_state_t *state,
             node->type = LAI_NAMESPACE_NAME;
             lai_do_resolve_new_node(node, ctx_handle, &amln);
             lai_var_move(&node->object, &object);
-            LAI_TRY(lai_install_nsnode(node));
-
             struct lai_ctxitem *ctxitem = lai_exec_peek_ctxstack_back(state);
-            if (ctxitem->invocation)
-                lai_list_link(&ctxitem->invocation->per_method_list, &node->per_method_item);
+            LAI_TRY(lai_exec_install_nsnode(ctxitem->invocation, node));
             break;
         }
         case BITFIELD_OP:
@@ -132,11 +175,8 @@ static lai_api_error_t lai_exec_reduce_node(int opcode, lai_state_t *state,
                     break;
             }
 
-            LAI_TRY(lai_install_nsnode(node));
-
             struct lai_ctxitem *ctxitem = lai_exec_peek_ctxstack_back(state);
-            if (ctxitem->invocation)
-                lai_list_link(&ctxitem->invocation->per_method_list, &node->per_method_item);
+            LAI_TRY(lai_exec_install_nsnode(ctxitem->invocation, node));
             break;
         }
         case (EXTOP_PREFIX << 8) | ARBFIELD_OP: {
@@ -162,11 +202,8 @@ static lai_api_error_t lai_exec_reduce_node(int opcode, lai_state_t *state,
             node->bf_size = size.integer;
             node->bf_offset = offset.integer;
 
-            LAI_TRY(lai_install_nsnode(node));
-
             struct lai_ctxitem *ctxitem = lai_exec_peek_ctxstack_back(state);
-            if (ctxitem->invocation)
-                lai_list_link(&ctxitem->invocation->per_method_list, &node->per_method_item);
+            LAI_TRY(lai_exec_install_nsnode(ctxitem->invocation, node));
             break;
         }
         case (EXTOP_PREFIX << 8) | OPREGION: {
@@ -189,11 +226,12 @@ static lai_api_error_t lai_exec_reduce_node(int opcode, lai_state_t *state,
             node->op_base = base.integer;
             node->op_length = size.integer;
 
-            LAI_TRY(lai_install_nsnode(node));
-
             struct lai_ctxitem *ctxitem = lai_exec_peek_ctxstack_back(state);
-            if (ctxitem->invocation)
-                lai_list_link(&ctxitem->invocation->per_method_list, &node->per_method_item);
+            LAI_TRY(lai_exec_install_nsnode(ctxitem->invocation, node));
+
+            // While tables are loaded, _REG is deferred until the whole table is available.
+            if (lai_exec_in_method(state))
+                lai_connect_opregion(node);
             break;
         }
         default:
@@ -203,10 +241,113 @@ static lai_api_error_t lai_exec_reduce_node(int opcode, lai_state_t *state,
     return LAI_ERROR_NONE;
 }
 
-static lai_api_error_t lai_exec_reduce_op(int opcode, lai_state_t *state,
-                                          struct lai_operand *operands,
-                                          lai_variable_t *reduction_res) {
-    if (lai_current_instance()->trace & LAI_TRACE_OP)
+#define LAI_OP_DESC_INITIALIZER(opcode, ...) [LAI_OP_INDEX(opcode)] = {{__VA_ARGS__}},
+
+const struct lai_op_desc lai_op_descs[512] = {LAI_FOREACH_OPERATOR(LAI_OP_DESC_INITIALIZER)};
+
+// Returns the integer value of an operand in LAI_OBJECT_MODE.
+static inline int lai_exec_peek_integer(struct lai_operand *operand, uint64_t *value) {
+    if (operand->tag != LAI_OPERAND_OBJECT || operand->object.type != LAI_INTEGER)
+        return 0;
+    *value = operand->object.integer;
+    return 1;
+}
+
+// Returns the LocalX or ArgX that a target refers to, or NULL if lai_operand_mutate() is needed.
+static inline lai_variable_t *lai_exec_peek_variable(lai_state_t *state,
+                                                     struct lai_operand *operand) {
+    if (operand->tag != LAI_LOCAL_NAME && operand->tag != LAI_ARG_NAME)
+        return NULL;
+    struct lai_invocation *invocation = lai_exec_peek_ctxstack_back(state)->invocation;
+    LAI_ENSURE(invocation);
+    if (operand->tag == LAI_LOCAL_NAME)
+        return &invocation->local[operand->index];
+
+    // Stores to ArgX that contain references go to the target of the reference.
+    lai_variable_t *var = &invocation->arg[operand->index];
+    if (var->type == LAI_ARG_REF || var->type == LAI_LOCAL_REF || var->type == LAI_NODE_REF)
+        return NULL;
+    return var;
+}
+
+// Integer-only version of lai_exec_reduce_op() for arithmetic, logical and comparison operators.
+// Operand types are checked once up front; afterwards, everything is done on uint64_t, without
+// lai_exec_get_integer() or result temporaries. All operands that are objects are integers, so
+// the caller does not need to finalize them. Returns zero (without side effects) if
+// lai_exec_reduce_op() has to be used instead.
+static int lai_exec_reduce_integer_op(int opcode, lai_state_t *state,
+                                      struct lai_operand *operands, uint64_t *result) {
+    uint64_t lhs, rhs;
+    struct lai_operand *target;
+    lai_variable_t *var;
+
+    switch (opcode) {
+        case INCREMENT_OP:
+        case DECREMENT_OP:
+            var = lai_exec_peek_variable(state, &operands[0]);
+            if (!var || var->type != LAI_INTEGER)
+                return 0;
+            if (opcode == INCREMENT_OP)
+                *result = ++var->integer;
+            else
+                *result = --var->integer;
+            return 1;
+        case NOT_OP:
+        case LNOT_OP:
+            if (!lai_exec_peek_integer(&operands[0], &lhs))
+                return 0;
+            *result = lai_op_eval_integer(opcode, lhs, 0);
+            if (opcode == LNOT_OP)
+                return 1;
+            target = &operands[1];
+            break;
+        case ADD_OP:
+        case SUBTRACT_OP:
+        case MULTIPLY_OP:
+        case AND_OP:
+        case OR_OP:
+        case XOR_OP:
+        case NAND_OP:
+        case NOR_OP:
+        case SHL_OP:
+        case SHR_OP:
+        case LAND_OP:
+        case LOR_OP:
+        case LEQUAL_OP:
+        case LLESS_OP:
+        case LGREATER_OP:
+            if (!lai_exec_peek_integer(&operands[0], &lhs)
+                || !lai_exec_peek_integer(&operands[1], &rhs))
+                return 0;
+            *result = lai_op_eval_integer(opcode, lhs, rhs);
+            // Only the arithmetic operators have a target.
+            if (lai_op_desc(opcode)->arg_modes[2] != LAI_REFERENCE_MODE)
+                return 1;
+            target = &operands[2];
+            break;
+        default:
+            return 0;
+    }
+
+    // Targets that are objects (e.g., returned by Index()) are left to lai_exec_reduce_op().
+    if (target->tag == LAI_OPERAND_OBJECT)
+        return 0;
+    if ((var = lai_exec_peek_variable(state, target))) {
+        if (var->type != LAI_INTEGER)
+            lai_var_finalize(var);
+        var->type = LAI_INTEGER;
+        var->integer = *result;
+    } else {
+        lai_variable_t object = {.type = LAI_INTEGER, .integer = *result};
+        lai_operand_mutate(state, target, &object);
+    }
+    return 1;
+}
+
+lai_api_error_t lai_exec_reduce_op(int opcode, lai_state_t *state, struct lai_operand *operands,
+                                   lai_variable_t *reduction_res) {
+    if ((lai_current_instance()->trace & LAI_TRACE_OP)
+        && !lai_trace_emit(LAI_TRACE_EVENT_REDUCE, opcode, 0, NULL, 0))
         lai_debug("lai_exec_reduce_op: opcode 0x%02X", opcode);
     lai_variable_t result = {0};
     switch (opcode) {
@@ -418,8 +559,8 @@ static lai_api_error_t lai_exec_reduce_op(int opcode, lai_state_t *state,
                         lai_warn("Failed to allocate memory for AML buffer");
                         return error;
                     }
-                    char *buffer0 = lai_exec_buffer_access(&operand0_convert);
-                    char *buffer1 = lai_exec_buffer_access(&operand1_convert);
+                    const char *buffer0 = lai_exec_buffer_view(&operand0_convert);
+                    const char *buffer1 = lai_exec_buffer_view(&operand1_convert);
                     char *result_buffer = lai_exec_buffer_access(&result);
                     memcpy(result_buffer, buffer0, b0size);
                     memcpy(result_buffer + b0size, buffer1, b0size);
@@ -469,8 +610,8 @@ static lai_api_error_t lai_exec_reduce_op(int opcode, lai_state_t *state,
                         lai_warn("failed to allocate memory for AML string");
                         return error;
                     }
-                    char *string0 = lai_exec_string_access(&operand0_convert);
-                    char *string1 = lai_exec_string_access(&operand1_convert);
+                    const char *string0 = lai_exec_string_view(&operand0_convert);
+                    const char *string1 = lai_exec_string_view(&operand1_convert);
                     char *result_string = lai_exec_string_access(&result);
                     memcpy(result_string, string0, s0len);
                     memcpy(result_string + s0len, string1, s1len);
@@ -725,7 +866,7 @@ static lai_api_error_t lai_exec_reduce_op(int opcode, lai_state_t *state,
                     result.type = LAI_STRING_INDEX;
                     result.string_ptr = object.string_ptr;
                     lai_rc_ref(&object.string_ptr->rc);
-                    result.integer = n;
+                    result.index = n;
                     break;
                 case LAI_BUFFER:
                     if (n >= lai_exec_buffer_size(&object))
@@ -733,14 +874,14 @@ static lai_api_error_t lai_exec_reduce_op(int opcode, lai_state_t *state,
                     result.type = LAI_BUFFER_INDEX;
                     result.buffer_ptr = object.buffer_ptr;
                     lai_rc_ref(&object.buffer_ptr->rc);
-                    result.integer = n;
+                    result.index = n;
                     break;
                 case LAI_PACKAGE:
                     if (n >= lai_exec_pkg_size(&object))
                         lai_panic("package Index() out of bounds");
                     result.type = LAI_PACKAGE_INDEX;
                     result.pkg_ptr = object.pkg_ptr;
-                    result.integer = n;
+                    result.index = n;
                     lai_rc_ref(&object.pkg_ptr->rc);
                     break;
                 default:
@@ -812,10 +953,10 @@ static lai_api_error_t lai_exec_reduce_op(int opcode, lai_state_t *state,
             lai_exec_get_objectref(state, &operands[1], &buf2_var);
 
             size_t buf1_size = lai_exec_buffer_size(&buf1_var);
-            const char *buf1 = lai_exec_buffer_access(&buf1_var);
+            const char *buf1 = lai_exec_buffer_view(&buf1_var);
 
             size_t buf2_size = lai_exec_buffer_size(&buf2_var);
-            const char *buf2 = lai_exec_buffer_access(&buf2_var);
+            const char *buf2 = lai_exec_buffer_view(&buf2_var);
 
             // Forbidden as per spec
             if (buf1_size == 1 || buf2_size == 1)
@@ -865,18 +1006,18 @@ static lai_api_error_t lai_exec_reduce_op(int opcode, lai_state_t *state,
                 case LAI_STRING_INDEX: {
                     char *window = ref.string_ptr->content;
                     result.type = LAI_INTEGER;
-                    result.integer = window[ref.integer];
+                    result.integer = window[ref.index];
                     break;
                 }
                 case LAI_BUFFER_INDEX: {
                     uint8_t *window = ref.buffer_ptr->content;
                     result.type = LAI_INTEGER;
-                    result.integer = window[ref.integer];
+                    result.integer = window[ref.index];
                     break;
                 }
                 case LAI_PACKAGE_INDEX:
                     // TODO: We need to panic if we load an uninitialized entry.
-                    lai_exec_pkg_var_load(&result, ref.pkg_ptr, ref.integer);
+                    lai_exec_pkg_var_load(&result, ref.pkg_ptr, ref.index);
                     break;
                 default:
                     lai_panic("Unexpected object type %d for DeRefOf()", ref.type);
@@ -932,6 +1073,7 @@ static lai_api_error_t lai_exec_reduce_op(int opcode, lai_state_t *state,
                 case LAI_RESOLVED_NAME:
                     ref.type = LAI_NODE_REF;
                     ref.handle = operand->handle;
+                    ref.handle->referenced = 1;
                     break;
                 default:
                     lai_panic("Unexpected operand tag %d for RefOf()", operand->tag);
@@ -1031,7 +1173,7 @@ static lai_api_error_t lai_exec_reduce_op(int opcode, lai_state_t *state,
                         lai_warn("failed to allocate memory for AML buffer");
                         return error;
                     }
-                    char *buffer0 = lai_exec_string_access(&object);
+                    const char *buffer0 = lai_exec_string_view(&object);
                     char *result_string = lai_exec_string_access(&result);
                     memcpy(result_string, buffer0 + n, sz);
                     result.type = LAI_STRING;
@@ -1043,7 +1185,7 @@ static lai_api_error_t lai_exec_reduce_op(int opcode, lai_state_t *state,
                         lai_warn("failed to allocate memory for AML buffer");
                         return error;
                     }
-                    char *buffer0 = lai_exec_buffer_access(&object);
+                    const char *buffer0 = lai_exec_buffer_view(&object);
                     char *result_buffer = lai_exec_buffer_access(&result);
                     memcpy(result_buffer, buffer0 + n, sz);
                     result.type = LAI_BUFFER;
@@ -1063,19 +1205,7 @@ static lai_api_error_t lai_exec_reduce_op(int opcode, lai_state_t *state,
             LAI_ENSURE(node->type == LAI_NAMESPACE_DEVICE || node->type == LAI_NAMESPACE_PROCESSOR
                        || node->type == LAI_NAMESPACE_THERMALZONE);
 
-            if (laihost_handle_global_notify)
-                laihost_handle_global_notify(node, code.integer);
-
-            if (node->notify_override) {
-                lai_api_error_t error;
-                error = node->notify_override(node, code.integer, node->notify_userptr);
-                // TODO: for now, there no errors defined.
-                //       Add a way for the host to signal Notify() failure.
-                LAI_ENSURE(!error);
-            } else {
-                LAI_CLEANUP_FREE_STRING char *path = lai_stringify_node_path(node);
-                lai_warn("Unhandled Notify(%s, 0x%lx)", path, code.integer);
-            }
+            lai_ns_notify(node, code.integer);
             break;
         }
 
@@ -1090,6 +1220,7 @@ static lai_api_error_t lai_exec_reduce_op(int opcode, lai_state_t *state,
                     if (operand->handle) {
                         ref.type = LAI_HANDLE;
                         ref.handle = operand->handle;
+                        ref.handle->referenced = 1;
                     }
                     break;
                 default:
@@ -1336,7 +1467,7 @@ static lai_api_error_t lai_exec_run(lai_state_t *state) {
     return 0;
 }
 
-static size_t lai_parse_varint(size_t *out, uint8_t *code, int *pc, int limit) {
+size_t lai_parse_varint(size_t *out, uint8_t *code, int *pc, int limit) {
     if (*pc + 1 > limit)
         return 1;
     uint8_t sz = (code[*pc] >> 6) & 3;
@@ -1374,6 +1505,200 @@ static int lai_parse_name(struct lai_amlname *out, uint8_t *code, int *pc, int l
     return 0;
 }
 
+// Returns true if the package initializer in [pc, limit) consists of exactly n integer
+// constants. Such packages (e.g., most entries of _PSS or _CST) are created in packed form.
+static int lai_is_integer_pkg_initializer(uint8_t *code, int pc, int limit, size_t n) {
+    size_t count = 0;
+    while (pc < limit) {
+        switch (code[pc]) {
+            case ZERO_OP:
+            case ONE_OP:
+            case ONES_OP:
+                pc += 1;
+                break;
+            case BYTEPREFIX:
+                pc += 2;
+                break;
+            case WORDPREFIX:
+                pc += 3;
+                break;
+            case DWORDPREFIX:
+                pc += 5;
+                break;
+            case QWORDPREFIX:
+                pc += 9;
+                break;
+            default:
+                return 0;
+        }
+        count++;
+    }
+    return pc == limit && count == n;
+}
+
+// Returns true if the data object at pc is a Package() or a Buffer() of constant size.
+// Such initializers do not depend on the namespace at the time of their evaluation.
+// On success, stores the size of the data object to *size.
+static int lai_is_static_name_initializer(uint8_t *code, int pc, int limit, size_t *size) {
+    int opcode_pc = pc;
+    size_t encoded_size;
+    if (pc >= limit)
+        return 0;
+    if (code[pc] == PACKAGE_OP) {
+        pc++;
+        if (lai_parse_varint(&encoded_size, code, &pc, limit))
+            return 0;
+    } else if (code[pc] == BUFFER_OP) {
+        pc++;
+        if (lai_parse_varint(&encoded_size, code, &pc, limit) || pc >= limit)
+            return 0;
+        if (code[pc] != ZERO_OP && code[pc] != ONE_OP && code[pc] != BYTEPREFIX
+            && code[pc] != WORDPREFIX && code[pc] != DWORDPREFIX && code[pc] != QWORDPREFIX)
+            return 0;
+    } else {
+        return 0;
+    }
+    if (encoded_size > (size_t)(limit - opcode_pc - 1))
+        return 0;
+    *size = 1 + encoded_size;
+    return 1;
+}
+
+// Translates a method to IR on its first invocation. Returns NULL if that is not possible.
+// The translation depends on the namespace (e.g., on which names refer to methods), so it is
+// redone once ns_generation changes.
+static struct lai_ir_method *lai_exec_get_ir(lai_nsnode_t *method) {
+    unsigned int generation = lai_current_instance()->ns_generation;
+    if (generation && method->mth_ir_generation == generation)
+        return method->mth_ir;
+
+    // Outer invocations might still run on the old IR; leave this one to the engine.
+    if (method->mth_invocation->outer_invocation)
+        return NULL;
+
+    if (method->mth_ir)
+        lai_ir_free(method->mth_ir);
+    method->mth_ir = lai_ir_compile(method);
+    method->mth_ir_generation = generation;
+    return method->mth_ir;
+}
+
+// Compares results of the IR and of the engine, see LAI_IR_COMPARE.
+static int lai_exec_same_result(lai_variable_t *lhs, lai_variable_t *rhs) {
+    if (lhs->type != rhs->type)
+        return 0;
+    switch (lhs->type) {
+        case LAI_INTEGER:
+        case LAI_STRING:
+        case LAI_BUFFER: {
+            int same;
+            if (lai_obj_exec_match_op(MATCH_MEQ, lhs, rhs, &same))
+                return 0;
+            return same;
+        }
+        case LAI_PACKAGE: {
+            size_t n = lai_exec_pkg_size(lhs);
+            if (n != lai_exec_pkg_size(rhs))
+                return 0;
+            for (size_t i = 0; i < n; i++) {
+                LAI_CLEANUP_VAR lai_variable_t lhs_elem = LAI_VAR_INITIALIZER;
+                LAI_CLEANUP_VAR lai_variable_t rhs_elem = LAI_VAR_INITIALIZER;
+                lai_exec_pkg_load(&lhs_elem, lhs, i);
+                lai_exec_pkg_load(&rhs_elem, rhs, i);
+                if (!lai_exec_same_result(&lhs_elem, &rhs_elem))
+                    return 0;
+            }
+            return 1;
+        }
+        default:
+            // References and other objects are only compared by type.
+            return 1;
+    }
+}
+
+// Runs a method on the engine (with the given arguments) and warns if the result
+// (or the error) differs from what the IR computed.
+static void lai_exec_compare_ir(lai_nsnode_t *method, int argc, lai_variable_t *args,
+                                lai_api_error_t ir_error, lai_variable_t *ir_result) {
+    struct lai_instance *instance = lai_current_instance();
+    int ir_flags = instance->ir_flags;
+    int memo_enabled = instance->memo_enabled;
+    instance->ir_flags = 0;
+    instance->memo_enabled = 0;
+
+    LAI_CLEANUP_STATE lai_state_t state;
+    lai_init_state(&state);
+    LAI_CLEANUP_VAR lai_variable_t result = LAI_VAR_INITIALIZER;
+    lai_api_error_t error = lai_eval_args(&result, method, &state, argc, args);
+
+    instance->ir_flags = ir_flags;
+    instance->memo_enabled = memo_enabled;
+
+    if (error != ir_error
+        || (error == LAI_ERROR_NONE && !lai_exec_same_result(&result, ir_result))) {
+        LAI_CLEANUP_FREE_STRING char *path = lai_stringify_node_path(method);
+        lai_warn("IR and engine disagree on the result of %s (error %d vs. %d)", path, ir_error,
+                 error);
+    }
+}
+
+// Runs the method at the top of the execution stack on the IR and returns from it.
+static lai_api_error_t lai_exec_run_ir(lai_state_t *state, struct lai_ir_method *ir) {
+    struct lai_ctxitem *ctxitem = lai_exec_peek_ctxstack_back(state);
+    lai_nsnode_t *method = ctxitem->handle;
+    struct lai_invocation *invocation = ctxitem->invocation;
+
+    // Only methods without side effects can be run twice. The IR may overwrite ArgX,
+    // so the engine gets copies of the original arguments.
+    int compare = lai_current_instance()->ir_flags & LAI_IR_COMPARE;
+    if (compare)
+        compare = lai_method_is_pure(method);
+    int argc = method->method_flags & METHOD_ARGC_MASK;
+    lai_variable_t args[7];
+    if (compare) {
+        memset(args, 0, sizeof(lai_variable_t) * 7);
+        for (int i = 0; i < argc; i++)
+            lai_obj_clone(&args[i], &invocation->arg[i]);
+    }
+
+    LAI_CLEANUP_VAR lai_variable_t result = LAI_VAR_INITIALIZER;
+    lai_api_error_t error = lai_ir_run(ir, state, &result);
+    if (compare) {
+        lai_exec_compare_ir(method, argc, args, error, &result);
+        for (int i = 0; i < argc; i++)
+            lai_var_finalize(&args[i]);
+    }
+    if (error != LAI_ERROR_NONE)
+        return error;
+
+    if (lai_exec_reserve_opstack(state))
+        return LAI_ERROR_OUT_OF_MEMORY;
+
+    lai_stackitem_t *item = lai_exec_peek_stack_back(state);
+    if (item->mth_want_result) {
+        struct lai_operand *opstack_res = lai_exec_push_opstack(state);
+        opstack_res->tag = LAI_OPERAND_OBJECT;
+        lai_var_move(&opstack_res->object, &result);
+    }
+
+    // Bank selections do not survive the method.
+    lai_invalidate_bank_cache();
+
+    // The IR does not create namespace nodes, so there is nothing to clean up.
+    LAI_ENSURE(!lai_list_first(&lai_exec_peek_ctxstack_back(state)->invocation->per_method_list));
+
+    lai_exec_pop_blkstack_back(state);
+    lai_exec_pop_ctxstack_back(state);
+    lai_exec_pop_stack_back(state);
+    return LAI_ERROR_NONE;
+}
+
+// Returns true if the context's code was verified against the current namespace.
+static inline int lai_exec_is_verified(struct lai_ctxitem *ctxitem) {
+    unsigned int generation = ctxitem->verified_generation;
+    return generation && generation == lai_current_instance()->ns_generation;
+}
+
 // Process the top-most item of the execution stack.
 static lai_api_error_t lai_exec_process(lai_state_t *state) {
     lai_stackitem_t *item = lai_exec_peek_stack_back(state);
@@ -1392,16 +1717,16 @@ static lai_api_error_t lai_exec_process(lai_state_t *state) {
     int opcode_pc = block->pc;
     int limit = block->limit;
 
-    // PC relative to the start of the table.
-    // This matches the offsets in the output of 'iasl -l'.
-    size_t table_pc = sizeof(acpi_header_t) + (method - amls->table->data) + opcode_pc;
-    size_t table_limit_pc = sizeof(acpi_header_t) + (method - amls->table->data) + block->limit;
-
     // This would be an interpreter bug.
-    if (block->pc > block->limit)
+    if (block->pc > block->limit && !lai_exec_is_verified(ctxitem)) {
+        // PC relative to the start of the table.
+        // This matches the offsets in the output of 'iasl -l'.
+        size_t table_pc = sizeof(acpi_header_t) + (method - amls->table->data) + opcode_pc;
+        size_t table_limit_pc = sizeof(acpi_header_t) + (method - amls->table->data) + limit;
         lai_panic("execution escaped out of code range"
                   " [0x%lx, limit 0x%lx])",
                   table_pc, table_limit_pc);
+    }
 
     if (item->kind == LAI_POPULATE_STACKITEM) {
         if (block->pc == block->limit) {
@@ -1413,6 +1738,13 @@ static lai_api_error_t lai_exec_process(lai_state_t *state) {
             return lai_exec_parse(LAI_EXEC_MODE, state);
         }
     } else if (item->kind == LAI_METHOD_STACKITEM) {
+        // Methods that the IR supports run to completion in a single step.
+        if (!block->pc && lai_current_instance()->ir_flags) {
+            struct lai_ir_method *ir = lai_exec_get_ir(ctx_handle);
+            if (ir)
+                return lai_exec_run_ir(state, ir);
+        }
+
         // ACPI does an implicit Return(0) at the end of a control method.
         if (block->pc == block->limit) {
             if (lai_exec_reserve_opstack(state))
@@ -1427,16 +1759,17 @@ static lai_api_error_t lai_exec_process(lai_state_t *state) {
                 result->object.integer = 0;
             }
 
+            // Bank selections do not survive the method.
+            lai_invalidate_bank_cache();
+
             // Clean up all per-method namespace nodes.
             struct lai_list_item *pmi;
             while ((pmi = lai_list_first(&invocation->per_method_list))) {
                 lai_nsnode_t *node = LAI_CONTAINER_OF(pmi, lai_nsnode_t, per_method_item);
 
                 if (node->type == LAI_NAMESPACE_BUFFER_FIELD) {
-                    if (lai_rc_unref(&node->bf_buffer->rc)) {
-                        laihost_free(node->bf_buffer->content, node->bf_buffer->size);
-                        laihost_free(node->bf_buffer, sizeof(struct lai_buffer_head));
-                    }
+                    lai_variable_t buffer = {.type = LAI_BUFFER, .buffer_ptr = node->bf_buffer};
+                    lai_var_finalize(&buffer);
                 }
 
                 lai_uninstall_nsnode(node);
@@ -1459,17 +1792,25 @@ static lai_api_error_t lai_exec_process(lai_state_t *state) {
             lai_exec_get_objectref(state, operand, &size);
             lai_exec_pop_opstack_back(state);
 
-            // Note that not all elements of the buffer need to be initialized.
-            LAI_CLEANUP_VAR lai_variable_t result = LAI_VAR_INITIALIZER;
-            if (lai_create_buffer(&result, size.integer) != LAI_ERROR_NONE)
-                lai_panic("failed to allocate memory for AML buffer");
-
             int initial_size = block->limit - block->pc;
             if (initial_size < 0)
                 lai_panic("buffer initializer has negative size");
-            if (initial_size > (int)lai_exec_buffer_size(&result))
+            if ((uint64_t)initial_size > size.integer)
                 lai_panic("buffer initializer overflows buffer");
-            memcpy(lai_exec_buffer_access(&result), method + block->pc, initial_size);
+
+            // Fully initialized buffers (e.g., resource templates) can borrow their contents
+            // from the AML table until they are modified. Small ones are stored inline instead.
+            LAI_CLEANUP_VAR lai_variable_t result = LAI_VAR_INITIALIZER;
+            if ((uint64_t)initial_size == size.integer && initial_size > LAI_SMALL_OBJECT_SIZE) {
+                if (lai_create_borrowed_buffer(&result, method + block->pc, initial_size)
+                    != LAI_ERROR_NONE)
+                    lai_panic("failed to allocate memory for AML buffer");
+            } else {
+                // Note that not all elements of the buffer need to be initialized.
+                if (lai_create_buffer(&result, size.integer) != LAI_ERROR_NONE)
+                    lai_panic("failed to allocate memory for AML buffer");
+                memcpy(lai_exec_buffer_access(&result), method + block->pc, initial_size);
+            }
 
             if (item->buf_want_result) {
                 // Note: there is no need to reserve() as we pop an operand above.
@@ -1502,7 +1843,12 @@ static lai_api_error_t lai_exec_process(lai_state_t *state) {
 
             lai_exec_pop_opstack_back(state);
 
-            if (lai_create_pkg(&frame[0].object, size.integer) != LAI_ERROR_NONE)
+            lai_api_error_t error;
+            if (lai_is_integer_pkg_initializer(method, block->pc, block->limit, size.integer))
+                error = lai_create_packed_pkg(&frame[0].object, size.integer);
+            else
+                error = lai_create_pkg(&frame[0].object, size.integer);
+            if (error != LAI_ERROR_NONE)
                 lai_panic("could not allocate memory for package");
 
             item->pkg_phase++;
@@ -1536,6 +1882,16 @@ static lai_api_error_t lai_exec_process(lai_state_t *state) {
         } else {
             return lai_exec_parse(LAI_DATA_MODE, state);
         }
+    } else if (item->kind == LAI_MATERIALIZE_STACKITEM) {
+        if (block->pc == block->limit) {
+            LAI_ENSURE(state->opstack_ptr == item->opstack_frame + 1);
+            lai_exec_pop_blkstack_back(state);
+            lai_exec_pop_ctxstack_back(state);
+            lai_exec_pop_stack_back(state);
+            return LAI_ERROR_NONE;
+        } else {
+            return lai_exec_parse(LAI_DATA_MODE, state);
+        }
     } else if (item->kind == LAI_NODE_STACKITEM) {
         int k = state->opstack_ptr - item->opstack_frame;
         if (!item->node_arg_modes[k]) {
@@ -1555,8 +1911,23 @@ static lai_api_error_t lai_exec_process(lai_state_t *state) {
             if (lai_exec_reserve_opstack(state))
                 return LAI_ERROR_OUT_OF_MEMORY;
 
-            lai_variable_t result = {0};
             struct lai_operand *operands = lai_exec_get_opstack(state, item->opstack_frame);
+            uint64_t integer;
+            if (!(lai_current_instance()->trace & LAI_TRACE_OP)
+                && lai_exec_reduce_integer_op(item->op_opcode, state, operands, &integer)) {
+                // The operands are integers (or names), hence they need not be finalized.
+                state->opstack_ptr -= k;
+                if (item->op_want_result) {
+                    struct lai_operand *opstack_res = lai_exec_push_opstack(state);
+                    opstack_res->tag = LAI_OPERAND_OBJECT;
+                    opstack_res->object.type = LAI_INTEGER;
+                    opstack_res->object.integer = integer;
+                }
+                lai_exec_pop_stack_back(state);
+                return LAI_ERROR_NONE;
+            }
+
+            lai_variable_t result = {0};
             lai_api_error_t error = lai_exec_reduce_op(item->op_opcode, state, operands, &result);
             if (error != LAI_ERROR_NONE) {
                 return error;
@@ -1628,11 +1999,16 @@ static lai_api_error_t lai_exec_process(lai_state_t *state) {
                 method_ctxitem->amls = handle->amls;
                 method_ctxitem->code = handle->pointer;
                 method_ctxitem->handle = handle;
+                if (lai_current_instance()->verify_enabled)
+                    method_ctxitem->verified_generation = lai_verified_generation(handle);
+                lai_profile_alloc();
                 method_ctxitem->invocation = laihost_malloc(sizeof(struct lai_invocation));
                 if (!method_ctxitem->invocation)
                     lai_panic("could not allocate memory for method invocation");
                 memset(method_ctxitem->invocation, 0, sizeof(struct lai_invocation));
                 lai_list_init(&method_ctxitem->invocation->per_method_list);
+                lai_ns_enter_invocation(method_ctxitem->invocation, handle);
+                lai_profile_enter(method_ctxitem->invocation, handle);
 
                 for (int i = 0; i < argc; i++)
                     lai_var_move(&method_ctxitem->invocation->arg[i], &args[i]);
@@ -1683,16 +2059,17 @@ static lai_api_error_t lai_exec_process(lai_state_t *state) {
                 lai_obj_clone(&opstack_res->object, &result);
             }
 
+            // Bank selections do not survive the method.
+            lai_invalidate_bank_cache();
+
             // Clean up all per-method namespace nodes.
             struct lai_list_item *pmi;
             while ((pmi = lai_list_first(&invocation->per_method_list))) {
                 lai_nsnode_t *node = LAI_CONTAINER_OF(pmi, lai_nsnode_t, per_method_item);
 
                 if (node->type == LAI_NAMESPACE_BUFFER_FIELD) {
-                    if (lai_rc_unref(&node->bf_buffer->rc)) {
-                        laihost_free(node->bf_buffer->content, node->bf_buffer->size);
-                        laihost_free(node->bf_buffer, sizeof(struct lai_buffer_head));
-                    }
+                    lai_variable_t buffer = {.type = LAI_BUFFER, .buffer_ptr = node->bf_buffer};
+                    lai_var_finalize(&buffer);
                 }
 
                 lai_uninstall_nsnode(node);
@@ -1849,10 +2226,7 @@ static lai_api_error_t lai_exec_process(lai_state_t *state) {
                         node->fld_bkf_bank_node = bank_node;
                         node->fld_bkf_value = bank_value;
                         lai_do_resolve_new_node(node, ctx_handle, &field_amln);
-                        LAI_TRY(lai_install_nsnode(node));
-
-                        if (invocation)
-                            lai_list_link(&invocation->per_method_list, &node->per_method_item);
+                        LAI_TRY(lai_exec_install_nsnode(invocation, node));
 
                         curr_off += skip_bits;
                 }
@@ -1868,42 +2242,6 @@ static lai_api_error_t lai_exec_process(lai_state_t *state) {
         lai_panic("unexpected lai_stackitem_t");
 }
 
-static inline int lai_parse_u8(uint8_t *out, uint8_t *code, int *pc, int limit) {
-    if (*pc + 1 > limit)
-        return 1;
-    *out = code[*pc];
-    (*pc)++;
-    return 0;
-}
-
-static inline int lai_parse_u16(uint16_t *out, uint8_t *code, int *pc, int limit) {
-    if (*pc + 2 > limit)
-        return 1;
-    *out = ((uint16_t)code[*pc]) | (((uint16_t)code[*pc + 1]) << 8);
-    *pc += 2;
-    return 0;
-}
-
-static inline int lai_parse_u32(uint32_t *out, uint8_t *code, int *pc, int limit) {
-    if (*pc + 4 > limit)
-        return 1;
-    *out = ((uint32_t)code[*pc]) | (((uint32_t)code[*pc + 1]) << 8)
-           | (((uint32_t)code[*pc + 2]) << 16) | (((uint32_t)code[*pc + 3]) << 24);
-    *pc += 4;
-    return 0;
-}
-
-static inline int lai_parse_u64(uint64_t *out, uint8_t *code, int *pc, int limit) {
-    if (*pc + 8 > limit)
-        return 1;
-    *out = ((uint64_t)code[*pc]) | (((uint64_t)code[*pc + 1]) << 8)
-           | (((uint64_t)code[*pc + 2]) << 16) | (((uint64_t)code[*pc + 3]) << 24)
-           | (((uint64_t)code[*pc + 4]) << 32) | (((uint64_t)code[*pc + 5]) << 40)
-           | (((uint64_t)code[*pc + 6]) << 48) | (((uint64_t)code[*pc + 7]) << 56);
-    *pc += 8;
-    return 0;
-}
-
 // Advances the PC of the current block.
 // lai_exec_parse() calls this function after successfully parsing a full opcode.
 // Even if parsing fails, this mechanism makes sure that the PC never points to
@@ -1939,7 +2277,9 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
     size_t table_pc = sizeof(acpi_header_t) + (method - amls->table->data) + opcode_pc;
     size_t table_limit_pc = sizeof(acpi_header_t) + (method - amls->table->data) + block->limit;
 
-    if (!(pc < block->limit))
+    // Verified code is decoded without bounds checks.
+    int verified = lai_exec_is_verified(ctxitem);
+    if (!verified && !(pc < block->limit))
         lai_panic("execution escaped out of code range"
                   " [0x%lx, limit 0x%lx])",
                   table_pc, table_limit_pc);
@@ -1950,7 +2290,9 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
 
     if (parse_mode == LAI_IMMEDIATE_BYTE_MODE) {
         uint8_t value = 0;
-        if (lai_parse_u8(&value, method, &pc, limit))
+        if (verified)
+            value = lai_decode_u8(method, &pc);
+        else if (lai_parse_u8(&value, method, &pc, limit))
             return LAI_ERROR_EXECUTION_FAILURE;
 
         if (lai_exec_reserve_opstack(state))
@@ -1964,7 +2306,9 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
         return LAI_ERROR_NONE;
     } else if (parse_mode == LAI_IMMEDIATE_WORD_MODE) {
         uint16_t value = 0;
-        if (lai_parse_u16(&value, method, &pc, limit))
+        if (verified)
+            value = lai_decode_u16(method, &pc);
+        else if (lai_parse_u16(&value, method, &pc, limit))
             return LAI_ERROR_EXECUTION_FAILURE;
 
         if (lai_exec_reserve_opstack(state))
@@ -1978,7 +2322,9 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
         return LAI_ERROR_NONE;
     } else if (parse_mode == LAI_IMMEDIATE_DWORD_MODE) {
         uint32_t value = 0;
-        if (lai_parse_u32(&value, method, &pc, limit))
+        if (verified)
+            value = lai_decode_u32(method, &pc);
+        else if (lai_parse_u32(&value, method, &pc, limit))
             return LAI_ERROR_EXECUTION_FAILURE;
 
         if (lai_exec_reserve_opstack(state))
@@ -2002,23 +2348,26 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
             return LAI_ERROR_OUT_OF_MEMORY;
         lai_exec_commit_pc(state, pc);
 
+        // Names are only stringified for textual traces.
         LAI_CLEANUP_FREE_STRING char *path = NULL;
-        if (instance->trace & LAI_TRACE_OP)
+        if ((instance->trace & LAI_TRACE_OP) && !instance->trace_ring)
             path = lai_stringify_amlname(&amln);
 
         if (parse_mode == LAI_DATA_MODE) {
-            if (instance->trace & LAI_TRACE_OP)
+            if ((instance->trace & LAI_TRACE_OP)
+                && !lai_trace_emit(LAI_TRACE_EVENT_NAME, 0, table_pc, NULL, 0))
                 lai_debug("parsing name %s [@ 0x%lx]", path, table_pc);
 
             if (want_result) {
                 struct lai_operand *opstack_res = lai_exec_push_opstack(state);
                 opstack_res->tag = LAI_OPERAND_OBJECT;
                 opstack_res->object.type = LAI_LAZY_HANDLE;
-                opstack_res->object.unres_ctx_handle = ctx_handle;
+                opstack_res->object.unres_scope = lai_ns_intern_lazy_scope(ctx_handle);
                 opstack_res->object.unres_aml = method + opcode_pc;
             }
         } else if (!(lai_mode_flags[parse_mode] & LAI_MF_RESOLVE)) {
-            if (instance->trace & LAI_TRACE_OP)
+            if ((instance->trace & LAI_TRACE_OP)
+                && !lai_trace_emit(LAI_TRACE_EVENT_NAME, 0, table_pc, NULL, 0))
                 lai_debug("parsing name %s [@ 0x%lx]", path, table_pc);
 
             if (want_result) {
@@ -2031,7 +2380,8 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
             lai_nsnode_t *handle = lai_do_resolve(ctx_handle, &amln);
             if (!handle) {
                 if (lai_mode_flags[parse_mode] & LAI_MF_NULLABLE) {
-                    if (instance->trace & LAI_TRACE_OP)
+                    if ((instance->trace & LAI_TRACE_OP)
+                        && !lai_trace_emit(LAI_TRACE_EVENT_NAME, 0, table_pc, NULL, 0))
                         lai_debug("parsing non-existant name %s [@ 0x%lx]", path, table_pc);
 
                     if (want_result) {
@@ -2046,7 +2396,8 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
                 }
             } else if (handle->type == LAI_NAMESPACE_METHOD
                        && (lai_mode_flags[parse_mode] & LAI_MF_INVOKE)) {
-                if (instance->trace & LAI_TRACE_OP)
+                if ((instance->trace & LAI_TRACE_OP)
+                    && !lai_trace_emit(LAI_TRACE_EVENT_INVOKE, 0, table_pc, handle, 0))
                     lai_debug("parsing invocation %s [@ 0x%lx]", path, table_pc);
 
                 lai_stackitem_t *node_item = lai_exec_push_stack(state);
@@ -2060,7 +2411,8 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
                 opstack_method->handle = handle;
             } else if (lai_mode_flags[parse_mode] & LAI_MF_INVOKE) {
                 // TODO: Get rid of this case again!
-                if (instance->trace & LAI_TRACE_OP)
+                if ((instance->trace & LAI_TRACE_OP)
+                    && !lai_trace_emit(LAI_TRACE_EVENT_NAME, 0, table_pc, handle, 0))
                     lai_debug("parsing name %s [@ 0x%lx]", path, table_pc);
 
                 LAI_CLEANUP_VAR lai_variable_t result = LAI_VAR_INITIALIZER;
@@ -2072,7 +2424,8 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
                     lai_var_move(&opstack_res->object, &result);
                 }
             } else {
-                if (instance->trace & LAI_TRACE_OP)
+                if ((instance->trace & LAI_TRACE_OP)
+                    && !lai_trace_emit(LAI_TRACE_EVENT_NAME, 0, table_pc, handle, 0))
                     lai_debug("parsing name %s [@ 0x%lx]", path, table_pc);
 
                 if (want_result) {
@@ -2088,7 +2441,7 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
     /* General opcodes */
     int opcode;
     if (method[pc] == EXTOP_PREFIX) {
-        if (pc + 1 == block->limit)
+        if (!verified && pc + 1 == block->limit)
             lai_panic("two-byte opcode on method boundary");
         opcode = (EXTOP_PREFIX << 8) | method[pc + 1];
         pc += 2;
@@ -2096,12 +2449,32 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
         opcode = method[pc];
         pc++;
     }
-    if (instance->trace & LAI_TRACE_OP) {
+    lai_profile_opcode();
+    if ((instance->trace & LAI_TRACE_OP)
+        && !lai_trace_emit(LAI_TRACE_EVENT_OPCODE, opcode, table_pc, ctx_handle, 0)) {
         lai_debug("parsing opcode 0x%02x [0x%lx @ %c%c%c%c %ld]", opcode, table_pc,
                   amls->table->header.signature[0], amls->table->header.signature[1],
                   amls->table->header.signature[2], amls->table->header.signature[3], amls->index);
     }
 
+#ifndef LAI_SWITCH_DISPATCH
+    // Operators only differ in their operands, hence they are described by a table.
+    const struct lai_op_desc *desc = lai_op_desc(opcode);
+    if (desc) {
+        if (lai_exec_reserve_stack(state))
+            return LAI_ERROR_OUT_OF_MEMORY;
+        lai_exec_commit_pc(state, pc);
+
+        lai_stackitem_t *op_item = lai_exec_push_stack(state);
+        op_item->kind = LAI_OP_STACKITEM;
+        op_item->op_opcode = opcode;
+        op_item->opstack_frame = state->opstack_ptr;
+        memcpy(op_item->op_arg_modes, desc->arg_modes, sizeof(desc->arg_modes));
+        op_item->op_want_result = want_result;
+        return LAI_ERROR_NONE;
+    }
+#endif
+
     // This switch handles the majority of all opcodes.
     switch (opcode) {
         case NOP_OP:
@@ -2201,27 +2574,35 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
             switch (opcode) {
                 case BYTEPREFIX: {
                     uint8_t temp;
-                    if (lai_parse_u8(&temp, method, &pc, limit))
+                    if (verified)
+                        temp = lai_decode_u8(method, &pc);
+                    else if (lai_parse_u8(&temp, method, &pc, limit))
                         return LAI_ERROR_EXECUTION_FAILURE;
                     value = temp;
                     break;
                 }
                 case WORDPREFIX: {
                     uint16_t temp;
-                    if (lai_parse_u16(&temp, method, &pc, limit))
+                    if (verified)
+                        temp = lai_decode_u16(method, &pc);
+                    else if (lai_parse_u16(&temp, method, &pc, limit))
                         return LAI_ERROR_EXECUTION_FAILURE;
                     value = temp;
                     break;
                 }
                 case DWORDPREFIX: {
                     uint32_t temp;
-                    if (lai_parse_u32(&temp, method, &pc, limit))
+                    if (verified)
+                        temp = lai_decode_u32(method, &pc);
+                    else if (lai_parse_u32(&temp, method, &pc, limit))
                         return LAI_ERROR_EXECUTION_FAILURE;
                     value = temp;
                     break;
                 }
                 case QWORDPREFIX: {
-                    if (lai_parse_u64(&value, method, &pc, limit))
+                    if (verified)
+                        value = lai_decode_u64(method, &pc);
+                    else if (lai_parse_u64(&value, method, &pc, limit))
                         return LAI_ERROR_EXECUTION_FAILURE;
                     break;
                 }
@@ -2243,10 +2624,14 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
         case STRINGPREFIX: {
             int data_pc;
             size_t n = 0; // Length of null-terminated string.
-            while (pc + n < (size_t)block->limit && method[pc + n])
-                n++;
-            if (pc + n == (size_t)block->limit)
-                lai_panic("unterminated string in AML code");
+            if (verified) {
+                n = lai_strlen((const char *)method + pc);
+            } else {
+                while (pc + n < (size_t)block->limit && method[pc + n])
+                    n++;
+                if (pc + n == (size_t)block->limit)
+                    lai_panic("unterminated string in AML code");
+            }
             data_pc = pc;
             pc += n + 1;
 
@@ -2267,7 +2652,9 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
         case BUFFER_OP: {
             int data_pc;
             size_t encoded_size; // Size of the buffer initializer.
-            if (lai_parse_varint(&encoded_size, method, &pc, limit))
+            if (verified)
+                encoded_size = lai_decode_varint(method, &pc);
+            else if (lai_parse_varint(&encoded_size, method, &pc, limit))
                 return LAI_ERROR_EXECUTION_FAILURE;
             data_pc = pc;
             pc = opcode_pc + 1 + encoded_size;
@@ -2289,7 +2676,9 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
         case VARPACKAGE_OP: {
             int data_pc;
             size_t encoded_size; // Size of the package initializer.
-            if (lai_parse_varint(&encoded_size, method, &pc, limit))
+            if (verified)
+                encoded_size = lai_decode_varint(method, &pc);
+            else if (lai_parse_varint(&encoded_size, method, &pc, limit))
                 return LAI_ERROR_EXECUTION_FAILURE;
             data_pc = pc;
             pc = opcode_pc + 1 + encoded_size;
@@ -2319,7 +2708,9 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
         case PACKAGE_OP: {
             int data_pc;
             size_t encoded_size; // Size of the package initializer.
-            if (lai_parse_varint(&encoded_size, method, &pc, limit))
+            if (verified)
+                encoded_size = lai_decode_varint(method, &pc);
+            else if (lai_parse_varint(&encoded_size, method, &pc, limit))
                 return LAI_ERROR_EXECUTION_FAILURE;
             data_pc = pc;
             pc = opcode_pc + 1 + encoded_size;
@@ -2363,7 +2754,9 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
         case WHILE_OP: {
             int body_pc;
             size_t loop_size;
-            if (lai_parse_varint(&loop_size, method, &pc, limit))
+            if (verified)
+                loop_size = lai_decode_varint(method, &pc);
+            else if (lai_parse_varint(&loop_size, method, &pc, limit))
                 return LAI_ERROR_EXECUTION_FAILURE;
             body_pc = pc;
             pc = opcode_pc + 1 + loop_size;
@@ -2449,14 +2842,18 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
             int has_else = 0;
             size_t if_size = 0;
             size_t else_size = 0;
-            if (lai_parse_varint(&if_size, method, &pc, limit))
+            if (verified)
+                if_size = lai_decode_varint(method, &pc);
+            else if (lai_parse_varint(&if_size, method, &pc, limit))
                 return LAI_ERROR_EXECUTION_FAILURE;
             if_pc = pc;
             pc = opcode_pc + 1 + if_size;
             if (pc < block->limit && method[pc] == ELSE_OP) {
                 has_else = 1;
                 pc++;
-                if (lai_parse_varint(&else_size, method, &pc, limit))
+                if (verified)
+                    else_size = lai_decode_varint(method, &pc);
+                else if (lai_parse_varint(&else_size, method, &pc, limit))
                     return LAI_ERROR_EXECUTION_FAILURE;
                 else_pc = pc;
                 pc = opcode_pc + 1 + if_size + 1 + else_size;
@@ -2537,10 +2934,7 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
             lai_nsnode_t *node = lai_create_nsnode_or_die();
             node->type = LAI_NAMESPACE_DEVICE;
             lai_do_resolve_new_node(node, ctx_handle, &amln);
-            LAI_TRY(lai_install_nsnode(node));
-
-            if (invocation)
-                lai_list_link(&invocation->per_method_list, &node->per_method_item);
+            LAI_TRY(lai_exec_install_nsnode(invocation, node));
 
             struct lai_ctxitem *populate_ctxitem = lai_exec_push_ctxstack(state);
             populate_ctxitem->amls = amls;
@@ -2582,10 +2976,7 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
             node->pblk_len = pblk_len;
 
             lai_do_resolve_new_node(node, ctx_handle, &amln);
-            LAI_TRY(lai_install_nsnode(node));
-
-            if (invocation)
-                lai_list_link(&invocation->per_method_list, &node->per_method_item);
+            LAI_TRY(lai_exec_install_nsnode(invocation, node));
 
             struct lai_ctxitem *populate_ctxitem = lai_exec_push_ctxstack(state);
             populate_ctxitem->amls = amls;
@@ -2622,10 +3013,7 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
             lai_nsnode_t *node = lai_create_nsnode_or_die();
             node->type = LAI_NAMESPACE_POWERRESOURCE;
             lai_do_resolve_new_node(node, ctx_handle, &amln);
-            LAI_TRY(lai_install_nsnode(node));
-
-            if (invocation)
-                lai_list_link(&invocation->per_method_list, &node->per_method_item);
+            LAI_TRY(lai_exec_install_nsnode(invocation, node));
 
             struct lai_ctxitem *populate_ctxitem = lai_exec_push_ctxstack(state);
             populate_ctxitem->amls = amls;
@@ -2658,10 +3046,7 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
             lai_nsnode_t *node = lai_create_nsnode_or_die();
             node->type = LAI_NAMESPACE_THERMALZONE;
             lai_do_resolve_new_node(node, ctx_handle, &amln);
-            LAI_TRY(lai_install_nsnode(node));
-
-            if (invocation)
-                lai_list_link(&invocation->per_method_list, &node->per_method_item);
+            LAI_TRY(lai_exec_install_nsnode(invocation, node));
 
             struct lai_ctxitem *populate_ctxitem = lai_exec_push_ctxstack(state);
             populate_ctxitem->amls = amls;
@@ -2698,10 +3083,7 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
             node->amls = amls;
             node->pointer = method + nested_pc;
             node->size = pc - nested_pc;
-            LAI_TRY(lai_install_nsnode(node));
-
-            if (invocation)
-                lai_list_link(&invocation->per_method_list, &node->per_method_item);
+            LAI_TRY(lai_exec_install_nsnode(invocation, node));
             break;
         }
         case EXTERNAL_OP: {
@@ -2715,7 +3097,9 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
 
             lai_exec_commit_pc(state, pc);
 
-            if (lai_current_instance()->trace & LAI_TRACE_OP) {
+            // Binary traces already contain the opcode.
+            if ((lai_current_instance()->trace & LAI_TRACE_OP)
+                && !lai_current_instance()->trace_ring) {
                 LAI_CLEANUP_FREE_STRING char *path = lai_stringify_amlname(&amln);
                 lai_debug(
                     "lai_exec_parse: ExternalOp, Name: %s, Object type: %02X, Argument Count: %01X",
@@ -2724,6 +3108,29 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
             break;
         }
         case NAME_OP: {
+            // Outside of methods, defer parsing of constant packages and buffers until they
+            // are accessed, see lai_exec_materialize_name().
+            if (!invocation) {
+                struct lai_amlname amln;
+                int data_pc = pc;
+                size_t data_size;
+                if (lai_parse_name(&amln, method, &data_pc, limit))
+                    return LAI_ERROR_EXECUTION_FAILURE;
+                if (lai_is_static_name_initializer(method, data_pc, limit, &data_size)) {
+                    lai_exec_commit_pc(state, data_pc + data_size);
+
+                    lai_nsnode_t *node = lai_create_nsnode_or_die();
+                    node->type = LAI_NAMESPACE_NAME;
+                    lai_do_resolve_new_node(node, ctx_handle, &amln);
+                    node->amls = amls;
+                    node->pointer = method + data_pc;
+                    node->size = data_size;
+                    node->name_lazy_ctx = ctx_handle;
+                    LAI_TRY(lai_install_nsnode(node));
+                    break;
+                }
+            }
+
             if (lai_exec_reserve_stack(state))
                 return LAI_ERROR_OUT_OF_MEMORY;
             lai_exec_commit_pc(state, pc);
@@ -2754,10 +3161,7 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
                           lai_stringify_amlname(&target_amln));
             lai_do_resolve_new_node(node, ctx_handle, &dest_amln);
 
-            LAI_TRY(lai_install_nsnode(node));
-
-            if (invocation)
-                lai_list_link(&invocation->per_method_list, &node->per_method_item);
+            LAI_TRY(lai_exec_install_nsnode(invocation, node));
             break;
         }
         case BITFIELD_OP:
@@ -2806,10 +3210,7 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
             lai_nsnode_t *node = lai_create_nsnode_or_die();
             node->type = LAI_NAMESPACE_MUTEX;
             lai_do_resolve_new_node(node, ctx_handle, &amln);
-            LAI_TRY(lai_install_nsnode(node));
-
-            if (invocation)
-                lai_list_link(&invocation->per_method_list, &node->per_method_item);
+            LAI_TRY(lai_exec_install_nsnode(invocation, node));
             break;
         }
         case (EXTOP_PREFIX << 8) | EVENT: {
@@ -2822,10 +3223,7 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
             lai_nsnode_t *node = lai_create_nsnode_or_die();
             node->type = LAI_NAMESPACE_EVENT;
             lai_do_resolve_new_node(node, ctx_handle, &amln);
-            LAI_TRY(lai_install_nsnode(node));
-
-            if (invocation)
-                lai_list_link(&invocation->per_method_list, &node->per_method_item);
+            LAI_TRY(lai_exec_install_nsnode(invocation, node));
             break;
         }
         case (EXTOP_PREFIX << 8) | OPREGION: {
@@ -2897,10 +3295,7 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
                         node->fld_size = skip_bits;
                         node->fld_offset = curr_off;
                         lai_do_resolve_new_node(node, ctx_handle, &field_amln);
-                        LAI_TRY(lai_install_nsnode(node));
-
-                        if (invocation)
-                            lai_list_link(&invocation->per_method_list, &node->per_method_item);
+                        LAI_TRY(lai_exec_install_nsnode(invocation, node));
 
                         curr_off += skip_bits;
                 }
@@ -2963,10 +3358,7 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
                         node->fld_size = skip_bits;
                         node->fld_offset = curr_off;
                         lai_do_resolve_new_node(node, ctx_handle, &field_amln);
-                        LAI_TRY(lai_install_nsnode(node));
-
-                        if (invocation)
-                            lai_list_link(&invocation->per_method_list, &node->per_method_item);
+                        LAI_TRY(lai_exec_install_nsnode(invocation, node));
 
                         curr_off += skip_bits;
                 }
@@ -3074,6 +3466,21 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
             break;
         }
 
+        case (EXTOP_PREFIX << 8) | DEBUG_OP: {
+            if (lai_exec_reserve_opstack(state))
+                return LAI_ERROR_OUT_OF_MEMORY;
+            lai_exec_commit_pc(state, pc);
+
+            // Accessing (i.e., loading from) the Debug object is not supported yet.
+            LAI_ENSURE(parse_mode == LAI_REFERENCE_MODE
+                       || parse_mode == LAI_OPTIONAL_REFERENCE_MODE);
+            struct lai_operand *result = lai_exec_push_opstack(state);
+            result->tag = LAI_DEBUG_NAME;
+            break;
+        }
+
+#ifdef LAI_SWITCH_DISPATCH
+        // Operators. Without LAI_SWITCH_DISPATCH, they are handled through lai_op_descs[].
         case TOBUFFER_OP: {
             if (lai_exec_reserve_stack(state))
                 return LAI_ERROR_OUT_OF_MEMORY;
@@ -3197,19 +3604,6 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
             break;
         }
 
-        case (EXTOP_PREFIX << 8) | DEBUG_OP: {
-            if (lai_exec_reserve_opstack(state))
-                return LAI_ERROR_OUT_OF_MEMORY;
-            lai_exec_commit_pc(state, pc);
-
-            // Accessing (i.e., loading from) the Debug object is not supported yet.
-            LAI_ENSURE(parse_mode == LAI_REFERENCE_MODE
-                       || parse_mode == LAI_OPTIONAL_REFERENCE_MODE);
-            struct lai_operand *result = lai_exec_push_opstack(state);
-            result->tag = LAI_DEBUG_NAME;
-            break;
-        }
-
         case STORE_OP:
         case COPYOBJECT_OP:
         case NOT_OP: {
@@ -3615,6 +4009,8 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
             break;
         }
 
+#endif
+
         default:
             lai_panic("unexpected opcode in lai_exec_run(), sequence %02X %02X %02X %02X",
                       method[opcode_pc + 0], method[opcode_pc + 1], method[opcode_pc + 2],
@@ -3623,8 +4019,61 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
     return LAI_ERROR_NONE;
 }
 
-lai_api_error_t lai_populate(lai_nsnode_t *parent, struct lai_aml_segment *amls,
-                             lai_state_t *state) {
+void lai_exec_enter_eval(void) {
+    lai_current_instance()->eval_depth++;
+    lai_invalidate_bank_cache();
+}
+
+void lai_exec_leave_eval(void) {
+    struct lai_instance *instance = lai_current_instance();
+    // Deliver queued Notify() operations once we return to the host.
+    if (!--instance->eval_depth && !(instance->notify_flags & LAI_NOTIFY_QUEUE_MANUAL))
+        lai_drain_notify_queue();
+}
+
+void lai_exec_materialize_name(lai_nsnode_t *node) {
+    if (node->type != LAI_NAMESPACE_NAME || !node->name_lazy_ctx)
+        return;
+
+    LAI_CLEANUP_STATE lai_state_t state;
+    lai_init_state(&state);
+    if (lai_exec_reserve_ctxstack(&state) || lai_exec_reserve_blkstack(&state)
+        || lai_exec_reserve_stack(&state))
+        lai_panic("could not allocate memory to parse Name() initializer");
+
+    struct lai_ctxitem *ctxitem = lai_exec_push_ctxstack(&state);
+    ctxitem->amls = node->amls;
+    ctxitem->code = node->amls->table->data;
+    ctxitem->handle = node->name_lazy_ctx;
+
+    struct lai_blkitem *blkitem = lai_exec_push_blkstack(&state);
+    blkitem->pc = (uint8_t *)node->pointer - ctxitem->code;
+    blkitem->limit = blkitem->pc + node->size;
+
+    lai_stackitem_t *item = lai_exec_push_stack(&state);
+    item->kind = LAI_MATERIALIZE_STACKITEM;
+    item->opstack_frame = 0;
+
+    lai_exec_enter_eval();
+    if (lai_exec_run(&state) != LAI_ERROR_NONE)
+        lai_panic("could not parse Name() initializer");
+    LAI_ENSURE(state.ctxstack_ptr == -1);
+    LAI_ENSURE(state.stack_ptr == -1);
+    LAI_ENSURE(state.opstack_ptr == 1);
+
+    struct lai_operand *result = lai_exec_get_opstack(&state, 0);
+    LAI_ENSURE(result->tag == LAI_OPERAND_OBJECT);
+    lai_var_move(&node->object, &result->object);
+    lai_exec_pop_opstack_back(&state);
+
+    node->name_lazy_ctx = NULL;
+    node->pointer = NULL;
+    node->size = 0;
+    lai_exec_leave_eval();
+}
+
+lai_api_error_t lai_exec_populate(lai_nsnode_t *parent, struct lai_aml_segment *amls,
+                                  lai_state_t *state) {
     if (lai_exec_reserve_ctxstack(state) || lai_exec_reserve_blkstack(state)
         || lai_exec_reserve_stack(state))
         return LAI_ERROR_OUT_OF_MEMORY;
@@ -3643,7 +4092,9 @@ lai_api_error_t lai_populate(lai_nsnode_t *parent, struct lai_aml_segment *amls,
     lai_stackitem_t *item = lai_exec_push_stack(state);
     item->kind = LAI_POPULATE_STACKITEM;
 
+    lai_exec_enter_eval();
     int status = lai_exec_run(state);
+    lai_exec_leave_eval();
     if (status != LAI_ERROR_NONE) {
         lai_warn("lai_exec_run() failed in lai_populate()");
         return status;
@@ -3654,6 +4105,15 @@ lai_api_error_t lai_populate(lai_nsnode_t *parent, struct lai_aml_segment *amls,
     return LAI_ERROR_NONE;
 }
 
+lai_api_error_t lai_populate(lai_nsnode_t *parent, struct lai_aml_segment *amls,
+                             lai_state_t *state) {
+    LAI_TRY(lai_exec_populate(parent, amls, state));
+
+    // Regions of tables that are loaded late still need to be connected to their handlers.
+    lai_connect_opregions();
+    return LAI_ERROR_NONE;
+}
+
 // lai_eval_args(): Evaluates a node of the ACPI namespace (including control methods).
 lai_api_error_t lai_eval_args(lai_variable_t *result, lai_nsnode_t *handle, lai_state_t *state,
                               int n, lai_variable_t *args) {
@@ -3666,6 +4126,7 @@ lai_api_error_t lai_eval_args(lai_variable_t *result, lai_nsnode_t *handle, lai_
                 lai_warn("non-empty argument list given when evaluating Name()");
                 return LAI_ERROR_TYPE_MISMATCH;
             }
+            lai_exec_materialize_name(handle);
             if (result)
                 lai_obj_clone(result, &handle->object);
             return LAI_ERROR_NONE;
@@ -3676,7 +4137,10 @@ lai_api_error_t lai_eval_args(lai_variable_t *result, lai_nsnode_t *handle, lai_
 
             LAI_CLEANUP_VAR lai_variable_t method_result = LAI_VAR_INITIALIZER;
             int e;
-            if (handle->method_override) {
+            int memoize = lai_current_instance()->memo_enabled && !handle->method_override;
+            if (memoize && lai_memo_lookup(handle, n, args, &method_result)) {
+                e = LAI_ERROR_NONE;
+            } else if (handle->method_override) {
                 // It's an OS-defined method.
                 // TODO: Verify the number of argument to the overridden method.
                 e = handle->method_override(args, &method_result);
@@ -3688,11 +4152,16 @@ lai_api_error_t lai_eval_args(lai_variable_t *result, lai_nsnode_t *handle, lai_
                 method_ctxitem->amls = handle->amls;
                 method_ctxitem->code = handle->pointer;
                 method_ctxitem->handle = handle;
+                if (lai_current_instance()->verify_enabled)
+                    method_ctxitem->verified_generation = lai_verified_generation(handle);
+                lai_profile_alloc();
                 method_ctxitem->invocation = laihost_malloc(sizeof(struct lai_invocation));
                 if (!method_ctxitem->invocation)
                     lai_panic("could not allocate memory for method invocation");
                 memset(method_ctxitem->invocation, 0, sizeof(struct lai_invocation));
                 lai_list_init(&method_ctxitem->invocation->per_method_list);
+                lai_ns_enter_invocation(method_ctxitem->invocation, handle);
+                lai_profile_enter(method_ctxitem->invocation, handle);
 
                 for (int i = 0; i < n; i++)
                     lai_var_assign(&method_ctxitem->invocation->arg[i], &args[i]);
@@ -3705,6 +4174,7 @@ lai_api_error_t lai_eval_args(lai_variable_t *result, lai_nsnode_t *handle, lai_
                 item->kind = LAI_METHOD_STACKITEM;
                 item->mth_want_result = 1;
 
+                lai_exec_enter_eval();
                 e = lai_exec_run(state);
 
                 if (e == LAI_ERROR_NONE) {
@@ -3712,18 +4182,21 @@ lai_api_error_t lai_eval_args(lai_variable_t *result, lai_nsnode_t *handle, lai_
                     LAI_ENSURE(state->stack_ptr == -1);
                     if (state->opstack_ptr != 1) // This would be an internal error.
                         lai_panic("expected exactly one return value after method invocation");
+                    // Return() already made a copy, so the value can be moved out.
                     struct lai_operand *opstack_top = lai_exec_get_opstack(state, 0);
-                    lai_variable_t objectref = {0};
-                    lai_exec_get_objectref(state, opstack_top, &objectref);
-                    lai_obj_clone(&method_result, &objectref);
-                    lai_var_finalize(&objectref);
+                    LAI_ENSURE(opstack_top->tag == LAI_OPERAND_OBJECT);
+                    lai_var_move(&method_result, &opstack_top->object);
                     lai_exec_pop_opstack(state, 1);
+                    if (memoize)
+                        lai_memo_store(handle, n, args, &method_result);
                 } else {
                     // If there is an error the lai_state_t is probably corrupted, we should reset
                     // it
                     lai_finalize_state(state);
                     lai_init_state(state);
                 }
+
+                lai_exec_leave_eval();
             }
             if (e == LAI_ERROR_NONE && result)
                 lai_var_move(result, &method_result);
@@ -3735,6 +4208,25 @@ lai_api_error_t lai_eval_args(lai_variable_t *result, lai_nsnode_t *handle, lai_
     }
 }
 
+lai_api_error_t lai_eval_view(struct lai_eval_view *view, lai_nsnode_t *handle,
+                              lai_state_t *state, int n, lai_variable_t *args) {
+    LAI_ENSURE(handle);
+    if (handle->type != LAI_NAMESPACE_NAME)
+        return lai_eval_args(&view->object, handle, state, n, args);
+
+    if (n) {
+        lai_warn("non-empty argument list given when evaluating Name()");
+        return LAI_ERROR_TYPE_MISMATCH;
+    }
+    lai_exec_materialize_name(handle);
+    lai_var_assign(&view->object, &handle->object);
+    return LAI_ERROR_NONE;
+}
+
+void lai_eval_view_release(struct lai_eval_view *view) {
+    lai_var_finalize(&view->object);
+}
+
 lai_api_error_t lai_eval_vargs(lai_variable_t *result, lai_nsnode_t *handle, lai_state_t *state,
                                va_list vl) {
     int n = 0;
@@ -3765,6 +4257,99 @@ lai_api_error_t lai_eval(lai_variable_t *result, lai_nsnode_t *handle, lai_state
     return lai_eval_args(result, handle, state, 0, NULL);
 }
 
+// Evaluates the object for the typed evaluators below.
+static lai_api_error_t lai_eval_typed(struct lai_eval_view *view, lai_nsnode_t *node,
+                                      const lai_path_t *path) {
+    if (path) {
+        node = lai_resolve_compiled_path(node, path);
+        if (!node)
+            return LAI_ERROR_NO_SUCH_NODE;
+    }
+    LAI_ENSURE(node);
+
+    // Name()s do not need an interpreter state at all.
+    if (node->type == LAI_NAMESPACE_NAME)
+        return lai_eval_view(view, node, NULL, 0, NULL);
+
+    // Reuse the instance's state (and the stacks that it already grew). If the evaluation
+    // is nested (e.g., from an address space handler), fall back to a fresh state.
+    struct lai_instance *instance = lai_current_instance();
+    if (instance->eval_state_busy) {
+        LAI_CLEANUP_STATE lai_state_t state;
+        lai_init_state(&state);
+        return lai_eval_view(view, node, &state, 0, NULL);
+    }
+
+    if (!instance->eval_state_initialized) {
+        lai_init_state(&instance->eval_state);
+        instance->eval_state_initialized = 1;
+    }
+    // lai_eval_args() leaves the state empty, both on success and on failure.
+    instance->eval_state_busy = 1;
+    lai_api_error_t e = lai_eval_view(view, node, &instance->eval_state, 0, NULL);
+    instance->eval_state_busy = 0;
+    return e;
+}
+
+lai_api_error_t lai_eval_u64(lai_nsnode_t *node, const lai_path_t *path, uint64_t *out) {
+    LAI_CLEANUP_EVAL_VIEW struct lai_eval_view view = LAI_EVAL_VIEW_INITIALIZER;
+    lai_api_error_t e = lai_eval_typed(&view, node, path);
+    if (e != LAI_ERROR_NONE)
+        return e;
+
+    if (view.object.type != LAI_INTEGER)
+        return LAI_ERROR_TYPE_MISMATCH;
+    *out = view.object.integer;
+    return LAI_ERROR_NONE;
+}
+
+lai_api_error_t lai_eval_string_into(lai_nsnode_t *node, const lai_path_t *path, char *buf,
+                                     size_t len) {
+    LAI_CLEANUP_EVAL_VIEW struct lai_eval_view view = LAI_EVAL_VIEW_INITIALIZER;
+    lai_api_error_t e = lai_eval_typed(&view, node, path);
+    if (e != LAI_ERROR_NONE)
+        return e;
+
+    if (view.object.type != LAI_STRING)
+        return LAI_ERROR_TYPE_MISMATCH;
+    size_t length = lai_exec_string_length(&view.object);
+    if (length + 1 > len)
+        return LAI_ERROR_OUT_OF_BOUNDS;
+    memcpy(buf, view.object.string_ptr->content, length);
+    buf[length] = '\0';
+    return LAI_ERROR_NONE;
+}
+
+lai_api_error_t lai_eval_buffer_into(lai_nsnode_t *node, const lai_path_t *path, void *buf,
+                                     size_t len, size_t *size_out) {
+    LAI_CLEANUP_EVAL_VIEW struct lai_eval_view view = LAI_EVAL_VIEW_INITIALIZER;
+    lai_api_error_t e = lai_eval_typed(&view, node, path);
+    if (e != LAI_ERROR_NONE)
+        return e;
+
+    if (view.object.type != LAI_BUFFER)
+        return LAI_ERROR_TYPE_MISMATCH;
+    size_t size = lai_exec_buffer_size(&view.object);
+    if (size_out)
+        *size_out = size;
+    if (size > len)
+        return LAI_ERROR_OUT_OF_BOUNDS;
+    memcpy(buf, lai_exec_buffer_view(&view.object), size);
+    return LAI_ERROR_NONE;
+}
+
 void lai_enable_tracing(int trace) {
     lai_current_instance()->trace = trace;
 }
+
+void lai_enable_ir(int flags) {
+    lai_current_instance()->ir_flags = flags;
+}
+
+void lai_enable_verifier(int enable) {
+    lai_current_instance()->verify_enabled = enable;
+}
+
+void lai_enable_memoization(int enable) {
+    lai_current_instance()->memo_enabled = enable;
+}
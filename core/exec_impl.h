@@ -9,6 +9,24 @@
 
 #include <lai/core.h>
 
+#include "profile.h"
+
+// Allocation and release of struct lai_storage (see core/object.c and core/variable.c).
+struct lai_storage *lai_create_storage(size_t size);
+void lai_release_storage(struct lai_storage *storage);
+void lai_release_pkg_storage(struct lai_storage *storage);
+
+// Creates a buffer that borrows its contents from the AML table, see struct lai_buffer_head.
+lai_api_error_t lai_create_borrowed_buffer(lai_variable_t *object, const uint8_t *data,
+                                           size_t size);
+
+// Creates a packed package, see struct lai_pkg_head. Its elements are initialized to zero.
+lai_api_error_t lai_create_packed_pkg(lai_variable_t *object, size_t n);
+
+static inline void *lai_storage_data(struct lai_storage *storage) {
+    return storage + 1;
+}
+
 struct lai_amlname {
     int is_absolute; // Is the path absolute or not?
     int height; // Number of scopes to exit before resolving the name.
@@ -38,10 +56,28 @@ char *lai_stringify_amlname(const struct lai_amlname *amln);
 // This will replace lai_resolve().
 lai_nsnode_t *lai_do_resolve(lai_nsnode_t *ctx_handle, const struct lai_amlname *amln);
 
+// Method-local namespace nodes (see core/ns.c).
+void lai_ns_enter_invocation(struct lai_invocation *invocation, lai_nsnode_t *method);
+void lai_ns_leave_invocation(struct lai_invocation *invocation);
+lai_api_error_t lai_ns_install_local(struct lai_invocation *invocation, lai_nsnode_t *node);
+
 // Used in the implementation of lai_resolve_new_node().
 void lai_do_resolve_new_node(lai_nsnode_t *node, lai_nsnode_t *ctx_handle,
                              const struct lai_amlname *amln);
 
+// Bracket runs of the interpreter. Once the outermost run returns to the host, queued Notify()
+// operations are delivered (see lai_enable_notify_queue()).
+void lai_exec_enter_eval(void);
+void lai_exec_leave_eval(void);
+
+// Like lai_populate(), but does not evaluate _REG for the new OperationRegions.
+lai_api_error_t lai_exec_populate(lai_nsnode_t *parent, struct lai_aml_segment *amls,
+                                  lai_state_t *state);
+
+// Outside of methods, Name()s of constant packages and buffers only keep a reference to their
+// initializer in the AML table. This parses the initializer on first access (if needed).
+void lai_exec_materialize_name(lai_nsnode_t *node);
+
 // Evaluate constant data (and keep result).
 //     Primitive objects are parsed.
 //     Names are left unresolved.
@@ -97,6 +133,84 @@ void lai_operand_emplace(lai_state_t *, struct lai_operand *, lai_variable_t *);
 void lai_exec_get_objectref(lai_state_t *, struct lai_operand *, lai_variable_t *);
 lai_api_error_t lai_exec_get_integer(lai_state_t *, struct lai_operand *, lai_variable_t *);
 
+// Performs an operator (e.g., Add()) on fully parsed operands.
+lai_api_error_t lai_exec_reduce_op(int opcode, lai_state_t *state, struct lai_operand *operands,
+                                   lai_variable_t *reduction_res);
+
+// Parsing of AML encodings. These functions return non-zero if the limit is exceeded.
+size_t lai_parse_varint(size_t *out, uint8_t *code, int *pc, int limit);
+
+static inline int lai_parse_u8(uint8_t *out, uint8_t *code, int *pc, int limit) {
+    if (*pc + 1 > limit)
+        return 1;
+    *out = code[*pc];
+    (*pc)++;
+    return 0;
+}
+
+static inline int lai_parse_u16(uint16_t *out, uint8_t *code, int *pc, int limit) {
+    if (*pc + 2 > limit)
+        return 1;
+    *out = ((uint16_t)code[*pc]) | (((uint16_t)code[*pc + 1]) << 8);
+    *pc += 2;
+    return 0;
+}
+
+static inline int lai_parse_u32(uint32_t *out, uint8_t *code, int *pc, int limit) {
+    if (*pc + 4 > limit)
+        return 1;
+    *out = ((uint32_t)code[*pc]) | (((uint32_t)code[*pc + 1]) << 8)
+           | (((uint32_t)code[*pc + 2]) << 16) | (((uint32_t)code[*pc + 3]) << 24);
+    *pc += 4;
+    return 0;
+}
+
+static inline int lai_parse_u64(uint64_t *out, uint8_t *code, int *pc, int limit) {
+    if (*pc + 8 > limit)
+        return 1;
+    *out = ((uint64_t)code[*pc]) | (((uint64_t)code[*pc + 1]) << 8)
+           | (((uint64_t)code[*pc + 2]) << 16) | (((uint64_t)code[*pc + 3]) << 24)
+           | (((uint64_t)code[*pc + 4]) << 32) | (((uint64_t)code[*pc + 5]) << 40)
+           | (((uint64_t)code[*pc + 6]) << 48) | (((uint64_t)code[*pc + 7]) << 56);
+    *pc += 8;
+    return 0;
+}
+
+// Decoding of AML encodings without bounds checks. Only valid for code that was accepted by
+// lai_verify_method().
+static inline uint8_t lai_decode_u8(uint8_t *code, int *pc) {
+    return code[(*pc)++];
+}
+
+static inline uint16_t lai_decode_u16(uint8_t *code, int *pc) {
+    uint16_t out;
+    lai_parse_u16(&out, code, pc, *pc + 2);
+    return out;
+}
+
+static inline uint32_t lai_decode_u32(uint8_t *code, int *pc) {
+    uint32_t out;
+    lai_parse_u32(&out, code, pc, *pc + 4);
+    return out;
+}
+
+static inline uint64_t lai_decode_u64(uint8_t *code, int *pc) {
+    uint64_t out;
+    lai_parse_u64(&out, code, pc, *pc + 8);
+    return out;
+}
+
+static inline size_t lai_decode_varint(uint8_t *code, int *pc) {
+    size_t out = code[*pc] & 0x3F;
+    int n = code[*pc] >> 6;
+    if (n)
+        out &= 0x0F;
+    for (int i = 0; i < n; i++)
+        out |= (size_t)code[*pc + 1 + i] << (4 + 8 * i);
+    *pc += 1 + n;
+    return out;
+}
+
 // --------------------------------------------------------------------------------------
 // Synchronization functions.
 // --------------------------------------------------------------------------------------
@@ -227,6 +341,7 @@ static inline void lai_event_reset(struct lai_sync_state *sync) {
 static inline int lai_exec_reserve_ctxstack(lai_state_t *state) {
     if (state->ctxstack_ptr + 1 == state->ctxstack_capacity) {
         size_t new_capacity = 2 * state->ctxstack_capacity;
+        lai_profile_alloc();
         struct lai_ctxitem *new_stack = laihost_malloc(new_capacity * sizeof(struct lai_ctxitem));
         if (!new_stack) {
             lai_warn("failed to allocate memory for context stack");
@@ -264,10 +379,12 @@ static inline void lai_exec_pop_ctxstack_back(lai_state_t *state) {
     LAI_ENSURE(state->ctxstack_ptr >= 0);
     struct lai_ctxitem *ctxitem = &state->ctxstack_base[state->ctxstack_ptr];
     if (ctxitem->invocation) {
+        lai_profile_leave(ctxitem->invocation);
         for (int i = 0; i < 7; i++)
             lai_var_finalize(&ctxitem->invocation->arg[i]);
         for (int i = 0; i < 8; i++)
             lai_var_finalize(&ctxitem->invocation->local[i]);
+        lai_ns_leave_invocation(ctxitem->invocation);
         laihost_free(ctxitem->invocation, sizeof(*ctxitem->invocation));
     }
     state->ctxstack_ptr -= 1;
@@ -280,6 +397,7 @@ static inline void lai_exec_pop_ctxstack_back(lai_state_t *state) {
 static inline int lai_exec_reserve_blkstack(lai_state_t *state) {
     if (state->blkstack_ptr + 1 == state->blkstack_capacity) {
         size_t new_capacity = 2 * state->blkstack_capacity;
+        lai_profile_alloc();
         struct lai_blkitem *new_stack = laihost_malloc(new_capacity * sizeof(struct lai_blkitem));
         if (!new_stack) {
             lai_warn("failed to allocate memory for block stack");
@@ -325,6 +443,7 @@ static inline void lai_exec_pop_blkstack_back(lai_state_t *state) {
 static inline int lai_exec_reserve_stack(lai_state_t *state) {
     if (state->stack_ptr + 1 == state->stack_capacity) {
         size_t new_capacity = 2 * state->stack_capacity;
+        lai_profile_alloc();
         lai_stackitem_t *new_stack = laihost_malloc(new_capacity * sizeof(lai_stackitem_t));
         if (!new_stack) {
             lai_warn("failed to allocate memory for execution stack");
@@ -379,6 +498,7 @@ static inline void lai_exec_pop_stack_back(lai_state_t *state) {
 static inline int lai_exec_reserve_opstack(lai_state_t *state) {
     if (state->opstack_ptr == state->opstack_capacity) {
         size_t new_capacity = 2 * state->opstack_capacity;
+        lai_profile_alloc();
         struct lai_operand *new_stack = laihost_malloc(new_capacity * sizeof(struct lai_operand));
         if (!new_stack) {
             lai_warn("failed to allocate memory for operand stack");
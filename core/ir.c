@@ -0,0 +1,1109 @@
+/*
+ * Lightweight AML Interpreter
+ * Copyright (C) 2018-2023 The lai authors
+ */
+
+#include <lai/core.h>
+
+#include "aml_opcodes.h"
+#include "eval.h"
+#include "exec_impl.h"
+#include "ir.h"
+#include "libc.h"
+#include "ops.h"
+#include "profile.h"
+
+// Instruction kinds.
+#define LAI_IR_CONSTANT 1 // dst = copy of constants[arg].
+#define LAI_IR_LOAD_LOCAL 2 // dst = LocalX (X = arg).
+#define LAI_IR_LOAD_ARG 3 // dst = ArgX (X = arg).
+#define LAI_IR_LOAD_NAME 4 // dst = value of names[arg].
+#define LAI_IR_INVOKE 5 // dst = names[arg](src, src + 1, ..., src + num_operands - 1).
+#define LAI_IR_OP 6 // dst = opcode(operands[arg], ..., operands[arg + num_operands - 1]).
+#define LAI_IR_JUMP 7 // Continue at instruction target.
+#define LAI_IR_JUMP_UNLESS 8 // Continue at instruction target if src is zero.
+#define LAI_IR_RETURN 9 // Return src.
+#define LAI_IR_OP_JUMP_UNLESS 10 // Like LAI_IR_OP, followed by LAI_IR_JUMP_UNLESS on the result.
+
+// Operand kinds of LAI_IR_OP.
+#define LAI_IR_OPERAND_REG 1
+// Targets.
+#define LAI_IR_OPERAND_LOCAL 2
+#define LAI_IR_OPERAND_ARG 3
+#define LAI_IR_OPERAND_NAME 4 // Resolved at run time.
+#define LAI_IR_OPERAND_OPTIONAL_NAME 5 // Like LAI_IR_OPERAND_NAME, but may be undefined.
+#define LAI_IR_OPERAND_NULL 6
+#define LAI_IR_OPERAND_DEBUG 7
+// Values that are read directly by the operator, without going through a register.
+#define LAI_IR_OPERAND_CONSTANT 8 // Copy of constants[index].
+#define LAI_IR_OPERAND_LOCAL_VALUE 9
+#define LAI_IR_OPERAND_ARG_VALUE 10
+#define LAI_IR_OPERAND_NAME_VALUE 11 // Value of names[index].
+
+// Registers are consumed (i.e., moved out of or finalized) by the instruction that reads them.
+#define LAI_IR_MAX_REGS 32
+// Value of dst if the result is discarded.
+#define LAI_IR_NO_REG 0xFF
+
+struct lai_ir_insn {
+    uint8_t kind;
+    uint8_t dst;
+    uint8_t src;
+    uint8_t num_operands;
+    uint16_t opcode;
+    uint32_t arg;
+    uint32_t target; // Of jumps.
+};
+
+struct lai_ir_operand {
+    int kind;
+    uint32_t index; // Register, LocalX/ArgX, constant or name, depending on the kind.
+};
+
+struct lai_ir_method {
+    struct lai_ir_insn *insns;
+    struct lai_ir_operand *operands;
+    lai_variable_t *constants;
+    struct lai_amlname *names;
+    size_t num_insns;
+    size_t num_operands;
+    size_t num_constants;
+    size_t num_names;
+    size_t insns_capacity;
+    size_t operands_capacity;
+    size_t constants_capacity;
+    size_t names_capacity;
+    int num_regs;
+};
+
+// --------------------------------------------------------------------------------------
+// Translation of AML to IR.
+// --------------------------------------------------------------------------------------
+
+// See struct lai_op_desc.
+#define LAI_IR_MAX_OPERANDS 7
+
+struct lai_ir_compiler {
+    lai_nsnode_t *method;
+    uint8_t *code;
+    struct lai_ir_method *ir;
+
+    int num_regs; // Number of registers that are currently in use.
+
+    // Innermost While() (if in_loop is set) and the LAI_IR_JUMPs that implement its Break()s.
+    int in_loop;
+    size_t loop_head;
+    size_t *breaks;
+    size_t num_breaks;
+    size_t breaks_capacity;
+};
+
+static int lai_ir_compile_term(struct lai_ir_compiler *c, int *pc, int limit, int want_result,
+                               int *reg);
+
+// Makes sure that there is room for another element in a dynamically sized array.
+static int lai_ir_grow(void **array, size_t *capacity, size_t size, size_t elem_size) {
+    if (size < *capacity)
+        return 0;
+    size_t new_capacity = *capacity ? 2 * *capacity : 16;
+    void *new_array = laihost_realloc(*array, new_capacity * elem_size, *capacity * elem_size);
+    if (!new_array)
+        return 1;
+    *array = new_array;
+    *capacity = new_capacity;
+    return 0;
+}
+
+static int lai_ir_peek_opcode(struct lai_ir_compiler *c, int pc, int limit) {
+    if (c->code[pc] != EXTOP_PREFIX)
+        return c->code[pc];
+    if (pc + 1 >= limit)
+        return EXTOP_PREFIX;
+    return (EXTOP_PREFIX << 8) | c->code[pc + 1];
+}
+
+static int lai_ir_alloc_reg(struct lai_ir_compiler *c, int *reg) {
+    if (c->num_regs == LAI_IR_MAX_REGS)
+        return 1;
+    *reg = c->num_regs++;
+    if (c->ir->num_regs < c->num_regs)
+        c->ir->num_regs = c->num_regs;
+    return 0;
+}
+
+static struct lai_ir_insn *lai_ir_emit(struct lai_ir_compiler *c, int kind) {
+    struct lai_ir_method *ir = c->ir;
+    if (lai_ir_grow((void **)&ir->insns, &ir->insns_capacity, ir->num_insns,
+                    sizeof(struct lai_ir_insn)))
+        return NULL;
+    struct lai_ir_insn *insn = &ir->insns[ir->num_insns++];
+    memset(insn, 0, sizeof(struct lai_ir_insn));
+    insn->kind = kind;
+    insn->dst = LAI_IR_NO_REG;
+    return insn;
+}
+
+// Emits an instruction that stores its result to a newly allocated register (if any).
+// Registers above base (i.e., the instruction's inputs) are released first.
+static struct lai_ir_insn *lai_ir_emit_result(struct lai_ir_compiler *c, int kind, int base,
+                                              int want_result, int *reg) {
+    c->num_regs = base;
+    if (want_result && lai_ir_alloc_reg(c, reg))
+        return NULL;
+    struct lai_ir_insn *insn = lai_ir_emit(c, kind);
+    if (insn && want_result)
+        insn->dst = *reg;
+    return insn;
+}
+
+// Takes ownership of the object.
+static int lai_ir_add_constant(struct lai_ir_compiler *c, lai_variable_t *object,
+                               uint32_t *index) {
+    struct lai_ir_method *ir = c->ir;
+    if (lai_ir_grow((void **)&ir->constants, &ir->constants_capacity, ir->num_constants,
+                    sizeof(lai_variable_t))) {
+        lai_var_finalize(object);
+        return 1;
+    }
+    *index = ir->num_constants;
+    lai_var_initialize(&ir->constants[ir->num_constants]);
+    lai_var_move(&ir->constants[ir->num_constants++], object);
+    return 0;
+}
+
+static int lai_ir_add_name(struct lai_ir_compiler *c, struct lai_amlname *amln, uint32_t *index) {
+    struct lai_ir_method *ir = c->ir;
+    if (lai_ir_grow((void **)&ir->names, &ir->names_capacity, ir->num_names,
+                    sizeof(struct lai_amlname)))
+        return 1;
+    *index = ir->num_names;
+    ir->names[ir->num_names++] = *amln;
+    return 0;
+}
+
+static int lai_ir_compile_name(struct lai_ir_compiler *c, int *pc, int limit,
+                               struct lai_amlname *amln, uint32_t *index) {
+    *pc += lai_amlname_parse(amln, c->code + *pc);
+    if (*pc > limit)
+        return 1;
+    return lai_ir_add_name(c, amln, index);
+}
+
+// Translates an immediate operand to a constant.
+static int lai_ir_compile_immediate(struct lai_ir_compiler *c, int *pc, int limit, int mode,
+                                    struct lai_ir_operand *out) {
+    lai_variable_t object = {.type = LAI_INTEGER};
+    if (mode == LAI_IMMEDIATE_BYTE_MODE) {
+        uint8_t value;
+        if (lai_parse_u8(&value, c->code, pc, limit))
+            return 1;
+        object.integer = value;
+    } else if (mode == LAI_IMMEDIATE_WORD_MODE) {
+        uint16_t value;
+        if (lai_parse_u16(&value, c->code, pc, limit))
+            return 1;
+        object.integer = value;
+    } else {
+        LAI_ENSURE(mode == LAI_IMMEDIATE_DWORD_MODE);
+        uint32_t value;
+        if (lai_parse_u32(&value, c->code, pc, limit))
+            return 1;
+        object.integer = value;
+    }
+    out->kind = LAI_IR_OPERAND_CONSTANT;
+    return lai_ir_add_constant(c, &object, &out->index);
+}
+
+// Translates terms that can be read without evaluating anything else first, i.e., LocalX, ArgX,
+// constants and named objects. Sets out->kind to zero (and leaves *pc unchanged) for other terms.
+static int lai_ir_compile_leaf(struct lai_ir_compiler *c, int *pc, int limit,
+                               struct lai_ir_operand *out) {
+    uint8_t *code = c->code;
+    out->kind = 0;
+    if (*pc >= limit)
+        return 1;
+
+    if (lai_is_name(code[*pc])) {
+        // Whether the name is invoked (and the number of arguments) is decided here.
+        // Names that do not exist yet are left to the engine.
+        struct lai_amlname amln;
+        int name_pc = *pc + lai_amlname_parse(&amln, code + *pc);
+        if (name_pc > limit)
+            return 1;
+        lai_nsnode_t *handle = lai_do_resolve(c->method, &amln);
+        if (!handle)
+            return 1;
+        if (handle->type == LAI_NAMESPACE_METHOD)
+            return 0;
+
+        *pc = name_pc;
+        out->kind = LAI_IR_OPERAND_NAME_VALUE;
+        return lai_ir_add_name(c, &amln, &out->index);
+    }
+
+    int opcode = lai_ir_peek_opcode(c, *pc, limit);
+    if (opcode >= LOCAL0_OP && opcode <= LOCAL7_OP) {
+        out->kind = LAI_IR_OPERAND_LOCAL_VALUE;
+        out->index = opcode - LOCAL0_OP;
+        (*pc)++;
+        return 0;
+    } else if (opcode >= ARG0_OP && opcode <= ARG6_OP) {
+        out->kind = LAI_IR_OPERAND_ARG_VALUE;
+        out->index = opcode - ARG0_OP;
+        (*pc)++;
+        return 0;
+    }
+
+    lai_variable_t object = {.type = LAI_INTEGER};
+    switch (opcode) {
+        case ZERO_OP:
+            (*pc)++;
+            break;
+        case ONE_OP:
+            (*pc)++;
+            object.integer = 1;
+            break;
+        case ONES_OP:
+            (*pc)++;
+            object.integer = ~((uint64_t)0);
+            break;
+        case (EXTOP_PREFIX << 8) | REVISION_OP:
+            *pc += 2;
+            object.integer = LAI_REVISION;
+            break;
+        case BYTEPREFIX:
+            (*pc)++;
+            return lai_ir_compile_immediate(c, pc, limit, LAI_IMMEDIATE_BYTE_MODE, out);
+        case WORDPREFIX:
+            (*pc)++;
+            return lai_ir_compile_immediate(c, pc, limit, LAI_IMMEDIATE_WORD_MODE, out);
+        case DWORDPREFIX:
+            (*pc)++;
+            return lai_ir_compile_immediate(c, pc, limit, LAI_IMMEDIATE_DWORD_MODE, out);
+        case QWORDPREFIX:
+            (*pc)++;
+            if (lai_parse_u64(&object.integer, code, pc, limit))
+                return 1;
+            break;
+        case STRINGPREFIX: {
+            size_t n = 0; // Length of null-terminated string.
+            (*pc)++;
+            while (*pc + n < (size_t)limit && code[*pc + n])
+                n++;
+            if (*pc + n == (size_t)limit)
+                return 1;
+            object.type = 0;
+            if (lai_create_string(&object, n) != LAI_ERROR_NONE)
+                return 1;
+            memcpy(lai_exec_string_access(&object), code + *pc, n);
+            *pc += n + 1;
+            break;
+        }
+        default:
+            return 0;
+    }
+    out->kind = LAI_IR_OPERAND_CONSTANT;
+    return lai_ir_add_constant(c, &object, &out->index);
+}
+
+// Emits code that reads a leaf into a newly allocated register (if want_result is set).
+static int lai_ir_compile_load(struct lai_ir_compiler *c, struct lai_ir_operand *leaf,
+                               int want_result, int *reg) {
+    static const int kinds[] = {
+        [LAI_IR_OPERAND_CONSTANT] = LAI_IR_CONSTANT,
+        [LAI_IR_OPERAND_LOCAL_VALUE] = LAI_IR_LOAD_LOCAL,
+        [LAI_IR_OPERAND_ARG_VALUE] = LAI_IR_LOAD_ARG,
+        [LAI_IR_OPERAND_NAME_VALUE] = LAI_IR_LOAD_NAME,
+    };
+
+    // Only reading a named object (which might be a field) has an effect in LAI_EXEC_MODE.
+    // LocalX and ArgX are only valid in LAI_OBJECT_MODE.
+    if (!want_result) {
+        if (leaf->kind == LAI_IR_OPERAND_LOCAL_VALUE || leaf->kind == LAI_IR_OPERAND_ARG_VALUE)
+            return 1;
+        if (leaf->kind == LAI_IR_OPERAND_CONSTANT)
+            return 0;
+    }
+
+    struct lai_ir_insn *insn =
+        lai_ir_emit_result(c, kinds[leaf->kind], c->num_regs, want_result, reg);
+    if (!insn)
+        return 1;
+    insn->arg = leaf->index;
+    return 0;
+}
+
+// Moves leaves that were not read yet into registers. This is necessary before translating
+// an operand that might have side effects, otherwise the leaves would be read too late.
+static int lai_ir_flush_leaves(struct lai_ir_compiler *c, struct lai_ir_operand *operands, int n) {
+    for (int i = 0; i < n; i++) {
+        int reg;
+        if (operands[i].kind < LAI_IR_OPERAND_CONSTANT)
+            continue;
+        if (lai_ir_compile_load(c, &operands[i], 1, &reg))
+            return 1;
+        operands[i].kind = LAI_IR_OPERAND_REG;
+        operands[i].index = reg;
+    }
+    return 0;
+}
+
+// Translates a target (i.e., an operand in LAI_REFERENCE_MODE or LAI_OPTIONAL_REFERENCE_MODE).
+// Leaves among the preceding operands are flushed if the target needs to be evaluated.
+static int lai_ir_compile_target(struct lai_ir_compiler *c, int *pc, int limit, int optional,
+                                 struct lai_ir_operand *preceding, int n,
+                                 struct lai_ir_operand *out) {
+    uint8_t *code = c->code;
+    if (*pc >= limit)
+        return 1;
+
+    if (lai_is_name(code[*pc])) {
+        struct lai_amlname amln;
+        out->kind = optional ? LAI_IR_OPERAND_OPTIONAL_NAME : LAI_IR_OPERAND_NAME;
+        return lai_ir_compile_name(c, pc, limit, &amln, &out->index);
+    }
+
+    int opcode = lai_ir_peek_opcode(c, *pc, limit);
+    if (opcode >= LOCAL0_OP && opcode <= LOCAL7_OP) {
+        out->kind = LAI_IR_OPERAND_LOCAL;
+        out->index = opcode - LOCAL0_OP;
+        (*pc)++;
+    } else if (opcode >= ARG0_OP && opcode <= ARG6_OP) {
+        out->kind = LAI_IR_OPERAND_ARG;
+        out->index = opcode - ARG0_OP;
+        (*pc)++;
+    } else if (opcode == ZERO_OP) {
+        out->kind = LAI_IR_OPERAND_NULL;
+        (*pc)++;
+    } else if (opcode == ((EXTOP_PREFIX << 8) | DEBUG_OP)) {
+        out->kind = LAI_IR_OPERAND_DEBUG;
+        *pc += 2;
+    } else if (lai_op_desc(opcode)) {
+        // Operators such as Index() or RefOf() yield the target as an object.
+        int reg;
+        if (lai_ir_flush_leaves(c, preceding, n) || lai_ir_compile_term(c, pc, limit, 1, &reg))
+            return 1;
+        out->kind = LAI_IR_OPERAND_REG;
+        out->index = reg;
+    } else {
+        return 1;
+    }
+    return 0;
+}
+
+// Operators that always return an integer and store it to their last operand.
+static int lai_ir_is_integer_op(int opcode) {
+    switch (opcode) {
+        case ADD_OP:
+        case SUBTRACT_OP:
+        case MULTIPLY_OP:
+        case MOD_OP:
+        case AND_OP:
+        case OR_OP:
+        case XOR_OP:
+        case NAND_OP:
+        case NOR_OP:
+        case SHL_OP:
+        case SHR_OP:
+        case NOT_OP:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+// Operators that always return an integer and have no target.
+static int lai_ir_is_logical_op(int opcode) {
+    switch (opcode) {
+        case LNOT_OP:
+        case LAND_OP:
+        case LOR_OP:
+        case LEQUAL_OP:
+        case LLESS_OP:
+        case LGREATER_OP:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static int lai_ir_emit_op(struct lai_ir_compiler *c, int opcode, struct lai_ir_operand *operands,
+                          int n, int base, int want_result, int *reg) {
+    struct lai_ir_method *ir = c->ir;
+
+    // Operands of nested operators were already added, hence we only add ours now.
+    size_t first = ir->num_operands;
+    for (int i = 0; i < n; i++) {
+        if (lai_ir_grow((void **)&ir->operands, &ir->operands_capacity, ir->num_operands,
+                        sizeof(struct lai_ir_operand)))
+            return 1;
+        ir->operands[ir->num_operands++] = operands[i];
+    }
+
+    struct lai_ir_insn *insn = lai_ir_emit_result(c, LAI_IR_OP, base, want_result, reg);
+    if (!insn)
+        return 1;
+    insn->opcode = opcode;
+    insn->num_operands = n;
+    insn->arg = first;
+    return 0;
+}
+
+// If store is set, the operator is the first operand of a Store() (whose opcode was already
+// consumed). Store(Add(X, Y), Z) is translated to Add(X, Y, Z): like Store(), integer
+// operators pass their result to lai_operand_mutate().
+static int lai_ir_compile_op(struct lai_ir_compiler *c, int *pc, int limit, int opcode,
+                             const struct lai_op_desc *desc, int store, int want_result,
+                             int *reg) {
+    struct lai_ir_operand operands[LAI_IR_MAX_OPERANDS];
+    int base = c->num_regs;
+    int n = 0;
+
+    *pc += (opcode > 0xFF) ? 2 : 1;
+    if (opcode == STORE_OP) {
+        int value_opcode = lai_ir_peek_opcode(c, *pc, limit);
+        if (lai_ir_is_integer_op(value_opcode))
+            return lai_ir_compile_op(c, pc, limit, value_opcode, lai_op_desc(value_opcode), 1,
+                                     want_result, reg);
+    }
+
+    for (; desc->arg_modes[n]; n++) {
+        LAI_ENSURE(n < LAI_IR_MAX_OPERANDS);
+        int mode = desc->arg_modes[n];
+        struct lai_ir_operand *operand = &operands[n];
+        if (mode == LAI_OBJECT_MODE) {
+            if (lai_ir_compile_leaf(c, pc, limit, operand))
+                return 1;
+            if (operand->kind)
+                continue;
+
+            int operand_reg;
+            if (lai_ir_flush_leaves(c, operands, n)
+                || lai_ir_compile_term(c, pc, limit, 1, &operand_reg))
+                return 1;
+            operand->kind = LAI_IR_OPERAND_REG;
+            operand->index = operand_reg;
+        } else if (mode == LAI_REFERENCE_MODE || mode == LAI_OPTIONAL_REFERENCE_MODE) {
+            if (lai_ir_compile_target(c, pc, limit, mode == LAI_OPTIONAL_REFERENCE_MODE,
+                                      operands, n, operand))
+                return 1;
+        } else {
+            if (lai_ir_compile_immediate(c, pc, limit, mode, operand))
+                return 1;
+        }
+    }
+    if (!store)
+        return lai_ir_emit_op(c, opcode, operands, n, base, want_result, reg);
+
+    // Replace the null target by the target of the Store().
+    struct lai_ir_operand *target = &operands[n - 1];
+    if (target->kind == LAI_IR_OPERAND_NULL)
+        return lai_ir_compile_target(c, pc, limit, 0, operands, n - 1, target)
+               || lai_ir_emit_op(c, opcode, operands, n, base, want_result, reg);
+
+    // Otherwise, the result is stored twice.
+    struct lai_ir_operand store_operands[2];
+    int value_reg;
+    if (lai_ir_emit_op(c, opcode, operands, n, base, 1, &value_reg))
+        return 1;
+    store_operands[0].kind = LAI_IR_OPERAND_REG;
+    store_operands[0].index = value_reg;
+    return lai_ir_compile_target(c, pc, limit, 0, NULL, 0, &store_operands[1])
+           || lai_ir_emit_op(c, STORE_OP, store_operands, 2, base, want_result, reg);
+}
+
+// Translates the term at *pc (in LAI_OBJECT_MODE if want_result is set and in LAI_EXEC_MODE
+// otherwise). The result is stored to a newly allocated register, which is returned in *reg.
+static int lai_ir_compile_term(struct lai_ir_compiler *c, int *pc, int limit, int want_result,
+                               int *reg) {
+    uint8_t *code = c->code;
+    int base = c->num_regs;
+    struct lai_ir_insn *insn;
+
+    struct lai_ir_operand leaf;
+    if (lai_ir_compile_leaf(c, pc, limit, &leaf))
+        return 1;
+    if (leaf.kind)
+        return lai_ir_compile_load(c, &leaf, want_result, reg);
+
+    if (lai_is_name(code[*pc])) {
+        // lai_ir_compile_leaf() already checked that the name refers to a method.
+        struct lai_amlname amln;
+        uint32_t name;
+        if (lai_ir_compile_name(c, pc, limit, &amln, &name))
+            return 1;
+        lai_nsnode_t *handle = lai_do_resolve(c->method, &amln);
+
+        int argc = handle->method_flags & METHOD_ARGC_MASK;
+        for (int i = 0; i < argc; i++) {
+            int arg_reg;
+            if (lai_ir_compile_term(c, pc, limit, 1, &arg_reg))
+                return 1;
+        }
+        if (!(insn = lai_ir_emit_result(c, LAI_IR_INVOKE, base, want_result, reg)))
+            return 1;
+        insn->src = base;
+        insn->num_operands = argc;
+        insn->arg = name;
+        return 0;
+    }
+
+    int opcode = lai_ir_peek_opcode(c, *pc, limit);
+    const struct lai_op_desc *desc = lai_op_desc(opcode);
+    if (!desc)
+        return 1;
+    return lai_ir_compile_op(c, pc, limit, opcode, desc, 0, want_result, reg);
+}
+
+static int lai_ir_compile_block(struct lai_ir_compiler *c, int pc, int limit);
+
+// Parses the package length of If(), Else() and While(). Returns the end of the package.
+static int lai_ir_compile_pkglength(struct lai_ir_compiler *c, int *pc, int limit, int *end) {
+    int opcode_pc = *pc;
+    size_t size;
+    (*pc)++;
+    if (lai_parse_varint(&size, c->code, pc, limit))
+        return 1;
+    if (size > (size_t)(limit - opcode_pc - 1))
+        return 1;
+    *end = opcode_pc + 1 + size;
+    return *pc > *end;
+}
+
+// Emits code that evaluates a predicate and branches if it is zero.
+// Returns the index of the branch, which needs to be patched by the caller.
+static int lai_ir_compile_branch(struct lai_ir_compiler *c, int *pc, int limit, size_t *branch) {
+    struct lai_ir_method *ir = c->ir;
+    int reg;
+    if (lai_ir_compile_term(c, pc, limit, 1, &reg))
+        return 1;
+    c->num_regs = reg;
+
+    // Comparisons such as LEqual() are fused with the branch.
+    struct lai_ir_insn *insn = &ir->insns[ir->num_insns - 1];
+    if (insn->kind == LAI_IR_OP && insn->dst == reg && lai_ir_is_logical_op(insn->opcode)) {
+        insn->kind = LAI_IR_OP_JUMP_UNLESS;
+        insn->dst = LAI_IR_NO_REG;
+        *branch = ir->num_insns - 1;
+        return 0;
+    }
+
+    *branch = ir->num_insns;
+    if (!(insn = lai_ir_emit(c, LAI_IR_JUMP_UNLESS)))
+        return 1;
+    insn->src = reg;
+    return 0;
+}
+
+static int lai_ir_compile_statement(struct lai_ir_compiler *c, int *pc, int limit) {
+    struct lai_ir_method *ir = c->ir;
+    uint8_t *code = c->code;
+    struct lai_ir_insn *insn;
+
+    switch (code[*pc]) {
+        case IF_OP: {
+            int if_limit;
+            size_t branch;
+            if (lai_ir_compile_pkglength(c, pc, limit, &if_limit)
+                || lai_ir_compile_branch(c, pc, if_limit, &branch)
+                || lai_ir_compile_block(c, *pc, if_limit))
+                return 1;
+            *pc = if_limit;
+
+            if (*pc < limit && code[*pc] == ELSE_OP) {
+                int else_limit;
+                if (lai_ir_compile_pkglength(c, pc, limit, &else_limit))
+                    return 1;
+                size_t skip = ir->num_insns;
+                if (!lai_ir_emit(c, LAI_IR_JUMP))
+                    return 1;
+                ir->insns[branch].target = ir->num_insns;
+                if (lai_ir_compile_block(c, *pc, else_limit))
+                    return 1;
+                *pc = else_limit;
+                ir->insns[skip].target = ir->num_insns;
+            } else {
+                ir->insns[branch].target = ir->num_insns;
+            }
+            return 0;
+        }
+        case WHILE_OP: {
+            int loop_limit;
+            size_t branch;
+            size_t head = ir->num_insns;
+            if (lai_ir_compile_pkglength(c, pc, limit, &loop_limit)
+                || lai_ir_compile_branch(c, pc, loop_limit, &branch))
+                return 1;
+
+            int outer_in_loop = c->in_loop;
+            size_t outer_head = c->loop_head;
+            size_t breaks_base = c->num_breaks;
+            c->in_loop = 1;
+            c->loop_head = head;
+            int failed = lai_ir_compile_block(c, *pc, loop_limit);
+            c->in_loop = outer_in_loop;
+            c->loop_head = outer_head;
+            if (failed)
+                return 1;
+            *pc = loop_limit;
+
+            if (!(insn = lai_ir_emit(c, LAI_IR_JUMP)))
+                return 1;
+            insn->target = head;
+            ir->insns[branch].target = ir->num_insns;
+            for (size_t i = breaks_base; i < c->num_breaks; i++)
+                ir->insns[c->breaks[i]].target = ir->num_insns;
+            c->num_breaks = breaks_base;
+            return 0;
+        }
+        case CONTINUE_OP:
+            if (!c->in_loop || !(insn = lai_ir_emit(c, LAI_IR_JUMP)))
+                return 1;
+            insn->target = c->loop_head;
+            (*pc)++;
+            return 0;
+        case BREAK_OP:
+            if (!c->in_loop
+                || lai_ir_grow((void **)&c->breaks, &c->breaks_capacity, c->num_breaks,
+                               sizeof(size_t)))
+                return 1;
+            c->breaks[c->num_breaks++] = ir->num_insns;
+            if (!lai_ir_emit(c, LAI_IR_JUMP))
+                return 1;
+            (*pc)++;
+            return 0;
+        case RETURN_OP: {
+            int reg;
+            (*pc)++;
+            if (lai_ir_compile_term(c, pc, limit, 1, &reg)
+                || !(insn = lai_ir_emit(c, LAI_IR_RETURN)))
+                return 1;
+            insn->src = reg;
+            c->num_regs = reg;
+            return 0;
+        }
+        case NOP_OP:
+            (*pc)++;
+            return 0;
+        default: {
+            int reg;
+            return lai_ir_compile_term(c, pc, limit, 0, &reg);
+        }
+    }
+}
+
+static int lai_ir_compile_block(struct lai_ir_compiler *c, int pc, int limit) {
+    while (pc < limit) {
+        if (lai_ir_compile_statement(c, &pc, limit))
+            return 1;
+    }
+    return 0;
+}
+
+struct lai_ir_method *lai_ir_compile(lai_nsnode_t *method) {
+    LAI_ENSURE(method->type == LAI_NAMESPACE_METHOD);
+
+    struct lai_ir_method *ir = laihost_malloc(sizeof(struct lai_ir_method));
+    if (!ir)
+        return NULL;
+    memset(ir, 0, sizeof(struct lai_ir_method));
+
+    struct lai_ir_compiler c = {0};
+    c.method = method;
+    c.code = method->pointer;
+    c.ir = ir;
+    int failed = lai_ir_compile_block(&c, 0, method->size);
+
+    if (c.breaks)
+        laihost_free(c.breaks, c.breaks_capacity * sizeof(size_t));
+    if (!failed)
+        return ir;
+    lai_ir_free(ir);
+    return NULL;
+}
+
+void lai_ir_free(struct lai_ir_method *ir) {
+    for (size_t i = 0; i < ir->num_constants; i++)
+        lai_var_finalize(&ir->constants[i]);
+    if (ir->insns)
+        laihost_free(ir->insns, ir->insns_capacity * sizeof(struct lai_ir_insn));
+    if (ir->operands)
+        laihost_free(ir->operands, ir->operands_capacity * sizeof(struct lai_ir_operand));
+    if (ir->constants)
+        laihost_free(ir->constants, ir->constants_capacity * sizeof(lai_variable_t));
+    if (ir->names)
+        laihost_free(ir->names, ir->names_capacity * sizeof(struct lai_amlname));
+    laihost_free(ir, sizeof(struct lai_ir_method));
+}
+
+size_t lai_ir_num_insns(struct lai_ir_method *ir) {
+    return ir->num_insns;
+}
+
+// --------------------------------------------------------------------------------------
+// Execution of IR.
+// --------------------------------------------------------------------------------------
+
+static lai_nsnode_t *lai_ir_resolve(struct lai_ir_method *ir, lai_nsnode_t *ctx_handle,
+                                    uint32_t index) {
+    lai_nsnode_t *handle = lai_do_resolve(ctx_handle, &ir->names[index]);
+    if (!handle) {
+        LAI_CLEANUP_FREE_STRING char *path = lai_stringify_amlname(&ir->names[index]);
+        lai_warn("undefined reference %s in object mode, aborting", path);
+    }
+    return handle;
+}
+
+static void lai_ir_store(lai_variable_t *regs, int dst, lai_variable_t *value) {
+    if (dst == LAI_IR_NO_REG)
+        lai_var_finalize(value);
+    else
+        lai_var_move(&regs[dst], value);
+}
+
+static lai_api_error_t lai_ir_invoke(lai_nsnode_t *handle, int argc, lai_variable_t *args,
+                                     lai_variable_t *result) {
+    if (handle->method_override) {
+        if (handle->method_override(args, result)) {
+            lai_warn("overriden control method failed");
+            return LAI_ERROR_EXECUTION_FAILURE;
+        }
+        return LAI_ERROR_NONE;
+    }
+
+    LAI_CLEANUP_STATE lai_state_t state;
+    lai_init_state(&state);
+    return lai_eval_args(result, handle, &state, argc, args);
+}
+
+// Invokes methods and reads other named objects, like the engine does. Whether a name is
+// invoked (and with how many arguments) is decided at translation time; if the namespace changed
+// since (e.g., in a method that the IR invoked), we can only continue as long as the engine
+// would parse the AML in the same way, i.e., if the number of arguments still matches.
+static lai_api_error_t lai_ir_eval_name(lai_nsnode_t *handle, int argc, lai_variable_t *args,
+                                        lai_variable_t *result) {
+    int expected_argc = 0;
+    if (handle->type == LAI_NAMESPACE_METHOD)
+        expected_argc = handle->method_flags & METHOD_ARGC_MASK;
+    if (expected_argc != argc) {
+        LAI_CLEANUP_FREE_STRING char *path = lai_stringify_node_path(handle);
+        lai_warn("IR expected %s to take %d arguments, but the namespace changed", path, argc);
+        return LAI_ERROR_EXECUTION_FAILURE;
+    }
+
+    if (handle->type != LAI_NAMESPACE_METHOD) {
+        lai_exec_access(result, handle);
+        return LAI_ERROR_NONE;
+    }
+    return lai_ir_invoke(handle, argc, args, result);
+}
+
+// Fills in the struct lai_operands of an LAI_IR_OP. Moves the objects out of the registers.
+static lai_api_error_t lai_ir_load_operands(struct lai_ir_method *ir, struct lai_ir_insn *insn,
+                                            lai_nsnode_t *ctx_handle,
+                                            struct lai_invocation *invocation,
+                                            lai_variable_t *regs, struct lai_operand *operands) {
+    for (int i = 0; i < insn->num_operands; i++) {
+        struct lai_ir_operand *desc = &ir->operands[insn->arg + i];
+        struct lai_operand *operand = &operands[i];
+        switch (desc->kind) {
+            case LAI_IR_OPERAND_REG:
+                operand->tag = LAI_OPERAND_OBJECT;
+                lai_var_initialize(&operand->object);
+                lai_var_move(&operand->object, &regs[desc->index]);
+                break;
+            case LAI_IR_OPERAND_LOCAL:
+                operand->tag = LAI_LOCAL_NAME;
+                operand->index = desc->index;
+                break;
+            case LAI_IR_OPERAND_ARG:
+                operand->tag = LAI_ARG_NAME;
+                operand->index = desc->index;
+                break;
+            case LAI_IR_OPERAND_NAME:
+                operand->tag = LAI_RESOLVED_NAME;
+                if (!(operand->handle = lai_ir_resolve(ir, ctx_handle, desc->index)))
+                    return LAI_ERROR_UNEXPECTED_RESULT;
+                break;
+            case LAI_IR_OPERAND_OPTIONAL_NAME:
+                operand->tag = LAI_RESOLVED_NAME;
+                operand->handle = lai_do_resolve(ctx_handle, &ir->names[desc->index]);
+                break;
+            case LAI_IR_OPERAND_NULL:
+                operand->tag = LAI_NULL_NAME;
+                break;
+            case LAI_IR_OPERAND_CONSTANT:
+                operand->tag = LAI_OPERAND_OBJECT;
+                lai_obj_clone(&operand->object, &ir->constants[desc->index]);
+                break;
+            case LAI_IR_OPERAND_LOCAL_VALUE:
+                operand->tag = LAI_OPERAND_OBJECT;
+                lai_var_assign(&operand->object, &invocation->local[desc->index]);
+                break;
+            case LAI_IR_OPERAND_ARG_VALUE:
+                operand->tag = LAI_OPERAND_OBJECT;
+                lai_var_assign(&operand->object, &invocation->arg[desc->index]);
+                break;
+            case LAI_IR_OPERAND_NAME_VALUE: {
+                lai_nsnode_t *handle = lai_ir_resolve(ir, ctx_handle, desc->index);
+                if (!handle)
+                    return LAI_ERROR_UNEXPECTED_RESULT;
+                operand->tag = LAI_OPERAND_OBJECT;
+                LAI_TRY(lai_ir_eval_name(handle, 0, NULL, &operand->object));
+                break;
+            }
+            default:
+                LAI_ENSURE(desc->kind == LAI_IR_OPERAND_DEBUG);
+                operand->tag = LAI_DEBUG_NAME;
+        }
+    }
+    return LAI_ERROR_NONE;
+}
+
+// Returns the value of an operand if it is an integer that can be read without side effects.
+static int lai_ir_peek_integer(struct lai_ir_method *ir, struct lai_invocation *invocation,
+                               lai_variable_t *regs, struct lai_ir_operand *operand,
+                               uint64_t *value) {
+    lai_variable_t *object;
+    switch (operand->kind) {
+        case LAI_IR_OPERAND_REG:
+            object = &regs[operand->index];
+            break;
+        case LAI_IR_OPERAND_CONSTANT:
+            object = &ir->constants[operand->index];
+            break;
+        case LAI_IR_OPERAND_LOCAL_VALUE:
+            object = &invocation->local[operand->index];
+            break;
+        case LAI_IR_OPERAND_ARG_VALUE:
+            object = &invocation->arg[operand->index];
+            break;
+        default:
+            return 0;
+    }
+    if (object->type != LAI_INTEGER)
+        return 0;
+    *value = object->integer;
+    return 1;
+}
+
+// Returns the variable that lai_operand_mutate() would overwrite (or NULL for the null target).
+// Fails for targets that need to be resolved or dereferenced.
+static int lai_ir_peek_target(struct lai_invocation *invocation, struct lai_ir_operand *operand,
+                              lai_variable_t **var) {
+    switch (operand->kind) {
+        case LAI_IR_OPERAND_NULL:
+            *var = NULL;
+            return 1;
+        case LAI_IR_OPERAND_LOCAL:
+            *var = &invocation->local[operand->index];
+            return 1;
+        case LAI_IR_OPERAND_ARG:
+            *var = &invocation->arg[operand->index];
+            switch ((*var)->type) {
+                case LAI_ARG_REF:
+                case LAI_LOCAL_REF:
+                case LAI_NODE_REF:
+                    return 0;
+                default:
+                    return 1;
+            }
+        default:
+            return 0;
+    }
+}
+
+// Fast path of LAI_IR_OP for operators on integers. Does nothing (and returns zero) unless
+// all operands are integers in registers, constants, LocalX or ArgX; in that case, we can
+// avoid the struct lai_operands and lai_exec_get_integer()/lai_operand_mutate().
+static int lai_ir_reduce_integer(struct lai_ir_method *ir, struct lai_ir_insn *insn,
+                                 struct lai_invocation *invocation, lai_variable_t *regs,
+                                 uint64_t *result) {
+    struct lai_ir_operand *operands = &ir->operands[insn->arg];
+    uint64_t lhs, rhs;
+    lai_variable_t *target;
+
+    switch (insn->opcode) {
+        case INCREMENT_OP:
+        case DECREMENT_OP:
+            if (!lai_ir_peek_target(invocation, &operands[0], &target) || !target
+                || target->type != LAI_INTEGER)
+                return 0;
+            if (insn->opcode == INCREMENT_OP)
+                *result = ++target->integer;
+            else
+                *result = --target->integer;
+            return 1;
+        case NOT_OP:
+            if (!lai_ir_peek_integer(ir, invocation, regs, &operands[0], &lhs)
+                || !lai_ir_peek_target(invocation, &operands[1], &target))
+                return 0;
+            *result = lai_op_eval_integer(insn->opcode, lhs, 0);
+            break;
+        case LNOT_OP:
+            if (!lai_ir_peek_integer(ir, invocation, regs, &operands[0], &lhs))
+                return 0;
+            *result = lai_op_eval_integer(insn->opcode, lhs, 0);
+            target = NULL;
+            break;
+        case ADD_OP:
+        case SUBTRACT_OP:
+        case MULTIPLY_OP:
+        case AND_OP:
+        case OR_OP:
+        case XOR_OP:
+        case NAND_OP:
+        case NOR_OP:
+        case SHL_OP:
+        case SHR_OP:
+            if (!lai_ir_peek_integer(ir, invocation, regs, &operands[0], &lhs)
+                || !lai_ir_peek_integer(ir, invocation, regs, &operands[1], &rhs)
+                || !lai_ir_peek_target(invocation, &operands[2], &target))
+                return 0;
+            *result = lai_op_eval_integer(insn->opcode, lhs, rhs);
+            break;
+        case LAND_OP:
+        case LOR_OP:
+        case LEQUAL_OP:
+        case LLESS_OP:
+        case LGREATER_OP:
+            if (!lai_ir_peek_integer(ir, invocation, regs, &operands[0], &lhs)
+                || !lai_ir_peek_integer(ir, invocation, regs, &operands[1], &rhs))
+                return 0;
+            *result = lai_op_eval_integer(insn->opcode, lhs, rhs);
+            target = NULL;
+            break;
+        default:
+            return 0;
+    }
+
+    // Integers do not need to be finalized, hence the registers are simply cleared.
+    for (int i = 0; i < insn->num_operands; i++) {
+        if (operands[i].kind == LAI_IR_OPERAND_REG)
+            regs[operands[i].index].type = 0;
+    }
+    if (target) {
+        if (target->type != LAI_INTEGER)
+            lai_var_finalize(target);
+        target->type = LAI_INTEGER;
+        target->integer = *result;
+    }
+    return 1;
+}
+
+lai_api_error_t lai_ir_run(struct lai_ir_method *ir, lai_state_t *state, lai_variable_t *result) {
+    struct lai_ctxitem *ctxitem = lai_exec_peek_ctxstack_back(state);
+    lai_nsnode_t *ctx_handle = ctxitem->handle;
+    struct lai_invocation *invocation = ctxitem->invocation;
+    LAI_ENSURE(invocation);
+
+    lai_api_error_t error = LAI_ERROR_NONE;
+    lai_variable_t regs[LAI_IR_MAX_REGS];
+    memset(regs, 0, ir->num_regs * sizeof(lai_variable_t));
+
+    size_t i = 0;
+    while (i < ir->num_insns) {
+        struct lai_ir_insn *insn = &ir->insns[i++];
+        lai_profile_opcode();
+        switch (insn->kind) {
+            case LAI_IR_CONSTANT:
+                lai_obj_clone(&regs[insn->dst], &ir->constants[insn->arg]);
+                break;
+            case LAI_IR_LOAD_LOCAL:
+                lai_var_assign(&regs[insn->dst], &invocation->local[insn->arg]);
+                break;
+            case LAI_IR_LOAD_ARG:
+                lai_var_assign(&regs[insn->dst], &invocation->arg[insn->arg]);
+                break;
+            case LAI_IR_LOAD_NAME:
+            case LAI_IR_INVOKE: {
+                lai_nsnode_t *handle = lai_ir_resolve(ir, ctx_handle, insn->arg);
+                if (!handle) {
+                    error = LAI_ERROR_UNEXPECTED_RESULT;
+                    goto out;
+                }
+
+                int argc = 0;
+                lai_variable_t args[7];
+                if (insn->kind == LAI_IR_INVOKE) {
+                    argc = insn->num_operands;
+                    memset(args, 0, sizeof(lai_variable_t) * 7);
+                    for (int k = 0; k < argc; k++)
+                        lai_var_move(&args[k], &regs[insn->src + k]);
+                }
+
+                lai_variable_t value = LAI_VAR_INITIALIZER;
+                error = lai_ir_eval_name(handle, argc, args, &value);
+                for (int k = 0; k < argc; k++)
+                    lai_var_finalize(&args[k]);
+                if (error != LAI_ERROR_NONE) {
+                    lai_var_finalize(&value);
+                    goto out;
+                }
+                lai_ir_store(regs, insn->dst, &value);
+                break;
+            }
+            case LAI_IR_OP:
+            case LAI_IR_OP_JUMP_UNLESS: {
+                lai_variable_t value = LAI_VAR_INITIALIZER;
+                uint64_t integer;
+                if (lai_ir_reduce_integer(ir, insn, invocation, regs, &integer)) {
+                    value.type = LAI_INTEGER;
+                    value.integer = integer;
+                } else {
+                    struct lai_operand operands[LAI_IR_MAX_OPERANDS];
+                    memset(operands, 0, sizeof(struct lai_operand) * insn->num_operands);
+                    error = lai_ir_load_operands(ir, insn, ctx_handle, invocation, regs, operands);
+                    if (error == LAI_ERROR_NONE)
+                        error = lai_exec_reduce_op(insn->opcode, state, operands, &value);
+                    for (int k = 0; k < insn->num_operands; k++) {
+                        if (operands[k].tag == LAI_OPERAND_OBJECT)
+                            lai_var_finalize(&operands[k].object);
+                    }
+                    if (error != LAI_ERROR_NONE)
+                        goto out;
+                }
+
+                if (insn->kind == LAI_IR_OP) {
+                    lai_ir_store(regs, insn->dst, &value);
+                } else {
+                    // Only operators that return integers are fused with branches.
+                    LAI_ENSURE(value.type == LAI_INTEGER);
+                    if (!value.integer)
+                        i = insn->target;
+                }
+                break;
+            }
+            case LAI_IR_JUMP:
+                i = insn->target;
+                break;
+            case LAI_IR_JUMP_UNLESS: {
+                lai_variable_t *predicate = &regs[insn->src];
+                if (!predicate->type) { // Uninitialized variable.
+                    error = LAI_ERROR_EXECUTION_FAILURE;
+                    goto out;
+                }
+                if (predicate->type != LAI_INTEGER)
+                    lai_panic("predicate must be an integer, not a value of type %d",
+                              predicate->type);
+                if (!predicate->integer)
+                    i = insn->target;
+                predicate->type = 0;
+                break;
+            }
+            default:
+                LAI_ENSURE(insn->kind == LAI_IR_RETURN);
+                lai_obj_clone(result, &regs[insn->src]);
+                goto out;
+        }
+    }
+
+    // ACPI does an implicit Return(0) at the end of a control method.
+    result->type = LAI_INTEGER;
+    result->integer = 0;
+
+out:
+    for (int k = 0; k < ir->num_regs; k++)
+        lai_var_finalize(&regs[k]);
+    return error;
+}
@@ -0,0 +1,32 @@
+/*
+ * Lightweight AML Interpreter
+ * Copyright (C) 2018-2023 The lai authors
+ */
+
+// Internal header file. Do not use outside of LAI.
+
+#pragma once
+
+#include <lai/core.h>
+
+// Register-based IR for control methods, see lai_enable_ir().
+//
+// Method bodies are translated into a flat array of instructions on their first invocation
+// (and again after the namespace changed).
+// Temporaries live in virtual registers, LocalX and ArgX are accessed directly and If/While
+// become branches. Methods that use anything that the IR does not cover (e.g., creation of
+// namespace nodes, Package() or Buffer()) are left to the stack-based engine.
+
+struct lai_ir_method;
+
+// Returns NULL if the method cannot be translated.
+struct lai_ir_method *lai_ir_compile(lai_nsnode_t *method);
+
+void lai_ir_free(struct lai_ir_method *ir);
+
+// Number of instructions after fusion, e.g., for tests.
+size_t lai_ir_num_insns(struct lai_ir_method *ir);
+
+// Runs the method on the invocation at the top of the state's context stack.
+// On success, stores a copy of the method's return value to result.
+lai_api_error_t lai_ir_run(struct lai_ir_method *ir, lai_state_t *state, lai_variable_t *result);
@@ -0,0 +1,118 @@
+/*
+ * Lightweight AML Interpreter
+ * Copyright (C) 2018-2023 The lai authors
+ */
+
+#include <lai/core.h>
+
+#include "exec_impl.h"
+#include "libc.h"
+#include "memo.h"
+#include "verify.h"
+
+// Number of cached invocations per method. Entries are replaced round-robin.
+#define LAI_MEMO_SIZE 4
+
+struct lai_memo_entry {
+    unsigned int ns_generation; // Zero if the entry is unused.
+    unsigned int store_generation;
+    int n;
+    lai_variable_t args[7];
+    lai_variable_t result;
+};
+
+struct lai_memo {
+    int next;
+    struct lai_memo_entry entries[LAI_MEMO_SIZE];
+};
+
+// Only plain values can be compared (and cached). In particular, references cannot.
+static int lai_memo_is_value(lai_variable_t *object) {
+    switch (object->type) {
+        case LAI_INTEGER:
+        case LAI_STRING:
+        case LAI_BUFFER:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static int lai_memo_equals(lai_variable_t *lhs, lai_variable_t *rhs) {
+    if (lhs->type != rhs->type)
+        return 0;
+    switch (lhs->type) {
+        case LAI_INTEGER:
+            return lhs->integer == rhs->integer;
+        case LAI_STRING:
+            return !lai_strcmp(lhs->string_ptr->content, rhs->string_ptr->content);
+        case LAI_BUFFER:
+            return lai_exec_buffer_size(lhs) == lai_exec_buffer_size(rhs)
+                   && !memcmp(lai_exec_buffer_view(lhs), lai_exec_buffer_view(rhs),
+                              lai_exec_buffer_size(lhs));
+        default:
+            lai_panic("unexpected object type %d in lai_memo_equals()", lhs->type);
+    }
+}
+
+static int lai_memo_is_valid(struct lai_memo_entry *entry) {
+    struct lai_instance *instance = lai_current_instance();
+    return entry->ns_generation == instance->ns_generation
+           && entry->store_generation == instance->store_generation;
+}
+
+int lai_memo_lookup(lai_nsnode_t *method, int n, lai_variable_t *args, lai_variable_t *result) {
+    struct lai_memo *memo = method->mth_memo;
+    if (!memo)
+        return 0;
+
+    for (int k = 0; k < LAI_MEMO_SIZE; k++) {
+        struct lai_memo_entry *entry = &memo->entries[k];
+        if (!entry->ns_generation || !lai_memo_is_valid(entry) || entry->n != n)
+            continue;
+        int i = 0;
+        while (i < n && lai_memo_equals(&entry->args[i], &args[i]))
+            i++;
+        if (i < n)
+            continue;
+        lai_obj_clone(result, &entry->result);
+        return 1;
+    }
+    return 0;
+}
+
+void lai_memo_store(lai_nsnode_t *method, int n, lai_variable_t *args, lai_variable_t *result) {
+    struct lai_instance *instance = lai_current_instance();
+    if (n > 7 || !instance->ns_generation)
+        return;
+    for (int i = 0; i < n; i++) {
+        if (!lai_memo_is_value(&args[i]))
+            return;
+    }
+    if (!lai_memo_is_value(result) && result->type != LAI_PACKAGE && result->type != LAI_HANDLE)
+        return;
+    if (!lai_method_is_pure(method))
+        return;
+
+    struct lai_memo *memo = method->mth_memo;
+    if (!memo) {
+        memo = laihost_malloc(sizeof(struct lai_memo));
+        if (!memo)
+            return;
+        memset(memo, 0, sizeof(struct lai_memo));
+        method->mth_memo = memo;
+    }
+
+    struct lai_memo_entry *entry = &memo->entries[memo->next];
+    memo->next = (memo->next + 1) % LAI_MEMO_SIZE;
+    for (int i = 0; i < entry->n; i++)
+        lai_var_finalize(&entry->args[i]);
+    lai_var_finalize(&entry->result);
+
+    entry->ns_generation = instance->ns_generation;
+    entry->store_generation = instance->store_generation;
+    entry->n = n;
+    for (int i = 0; i < n; i++)
+        lai_obj_clone(&entry->args[i], &args[i]);
+    lai_obj_clone(&entry->result, result);
+}
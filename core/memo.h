@@ -0,0 +1,22 @@
+/*
+ * Lightweight AML Interpreter
+ * Copyright (C) 2018-2023 The lai authors
+ */
+
+// Internal header file. Do not use outside of LAI.
+
+#pragma once
+
+#include <lai/core.h>
+
+// Memoization of method results, see lai_enable_memoization().
+//
+// Only pure methods (see lai_method_is_pure()) are memoized. Their results only depend on the
+// arguments, on the namespace and on the contents of Name() objects. Hence, cached results are
+// valid as long as lai_current_instance()->ns_generation and ->store_generation do not change.
+
+// Returns true (and stores a copy of the result) if the invocation is cached.
+int lai_memo_lookup(lai_nsnode_t *method, int n, lai_variable_t *args, lai_variable_t *result);
+
+// Caches the result of an invocation. Does nothing if the method is not pure.
+void lai_memo_store(lai_nsnode_t *method, int n, lai_variable_t *args, lai_variable_t *result);
@@ -12,7 +12,13 @@
 #include "exec_impl.h"
 #include "libc.h"
 #include "ns_impl.h"
+#include "opregion.h"
+#include "profile.h"
+#include "trace.h"
 #include "util-hash.h"
+#include "util-list.h"
+#include "util-macros.h"
+#include "verify.h"
 
 static int debug_resolution = 0;
 
@@ -36,6 +42,7 @@ static unsigned int lai_hash_string(const char *str, size_t n) {
 }
 
 lai_nsnode_t *lai_create_nsnode(void) {
+    lai_profile_alloc();
     lai_nsnode_t *node = laihost_malloc(sizeof(lai_nsnode_t));
     if (!node)
         return NULL;
@@ -56,7 +63,8 @@ lai_nsnode_t *lai_create_nsnode_or_die(void) {
 lai_api_error_t lai_install_nsnode(lai_nsnode_t *node) {
     struct lai_instance *instance = lai_current_instance();
 
-    if (instance->trace & LAI_TRACE_NS) {
+    if ((instance->trace & LAI_TRACE_NS)
+        && !lai_trace_emit(LAI_TRACE_EVENT_NS_INSTALL, node->type, 0, node, 0)) {
         LAI_CLEANUP_FREE_STRING char *fullpath = lai_stringify_node_path(node);
         lai_debug("lai_install_nsnode: adding node with type %d at %s", node->type, fullpath);
     }
@@ -75,6 +83,7 @@ lai_api_error_t lai_install_nsnode(lai_nsnode_t *node) {
     }
 
     instance->ns_array[instance->ns_size++] = node;
+    instance->ns_generation++;
 
     // Insert the node into its parent's hash table.
     lai_nsnode_t *parent = node->parent;
@@ -97,8 +106,13 @@ lai_api_error_t lai_install_nsnode(lai_nsnode_t *node) {
     return LAI_ERROR_NONE;
 }
 
+static void lai_ns_release_lazy_scope(lai_nsnode_t *node);
+
 void lai_uninstall_nsnode(lai_nsnode_t *node) {
     struct lai_instance *instance = lai_current_instance();
+    instance->ns_generation++;
+    lai_ns_cancel_notify(node);
+    lai_ns_release_lazy_scope(node);
 
     for (size_t i = 0; i < instance->ns_size; i++) {
         if (instance->ns_array[i] == node)
@@ -131,6 +145,180 @@ void lai_uninstall_nsnode(lai_nsnode_t *node) {
     }
 }
 
+// Nodes that a method creates in its own scope are method-local: they are only linked into the
+// invocation's local_list (instead of the parent's hash table and ns_array) and freed in bulk
+// once the invocation ends. lai_ns_get_child() consults the innermost invocation of a method
+// before the method's global children. Nodes that references were taken to (e.g., by RefOf())
+// may outlive the method; they are only unlinked and never freed, just like the nodes that
+// lai_uninstall_nsnode() removes.
+void lai_ns_enter_invocation(struct lai_invocation *invocation, lai_nsnode_t *method) {
+    LAI_ENSURE(method->type == LAI_NAMESPACE_METHOD);
+    lai_list_init(&invocation->local_list);
+    invocation->local_scope = method;
+    invocation->outer_invocation = method->mth_invocation;
+    method->mth_invocation = invocation;
+}
+
+void lai_ns_leave_invocation(struct lai_invocation *invocation) {
+    lai_nsnode_t *method = invocation->local_scope;
+    LAI_ENSURE(method->mth_invocation == invocation);
+    method->mth_invocation = invocation->outer_invocation;
+
+    struct lai_list_item *item;
+    while ((item = lai_list_first(&invocation->local_list))) {
+        lai_nsnode_t *node = LAI_CONTAINER_OF(item, lai_nsnode_t, per_method_item);
+        lai_list_unlink(&node->per_method_item);
+        lai_ns_cancel_notify(node);
+        lai_ns_release_lazy_scope(node);
+        if (node->referenced)
+            continue;
+
+        if (node->type == LAI_NAMESPACE_NAME) {
+            lai_var_finalize(&node->object);
+        } else if (node->type == LAI_NAMESPACE_BUFFER_FIELD) {
+            lai_variable_t buffer = {.type = LAI_BUFFER, .buffer_ptr = node->bf_buffer};
+            lai_var_finalize(&buffer);
+        }
+        laihost_free(node, sizeof(lai_nsnode_t));
+    }
+}
+
+static lai_nsnode_t *lai_ns_get_local(struct lai_invocation *invocation, const char *name) {
+    struct lai_list_item *item = lai_list_first(&invocation->local_list);
+    while (item) {
+        lai_nsnode_t *node = LAI_CONTAINER_OF(item, lai_nsnode_t, per_method_item);
+        if (!memcmp(node->name, name, 4))
+            return node;
+        item = lai_list_next(&invocation->local_list, item);
+    }
+    return NULL;
+}
+
+lai_api_error_t lai_ns_install_local(struct lai_invocation *invocation, lai_nsnode_t *node) {
+    LAI_ENSURE(node->parent == invocation->local_scope);
+
+    if ((lai_current_instance()->trace & LAI_TRACE_NS)
+        && !lai_trace_emit(LAI_TRACE_EVENT_NS_INSTALL, node->type, 0, node, 0)) {
+        LAI_CLEANUP_FREE_STRING char *fullpath = lai_stringify_node_path(node);
+        lai_debug("lai_ns_install_local: adding node with type %d at %s", node->type, fullpath);
+    }
+
+    if (lai_ns_get_local(invocation, node->name)) {
+        LAI_CLEANUP_FREE_STRING char *fullpath = lai_stringify_node_path(node);
+        lai_warn("trying to install duplicate namespace node %s, ignoring", fullpath);
+        return LAI_ERROR_UNEXPECTED_RESULT;
+    }
+
+    lai_list_link(&invocation->local_list, &node->per_method_item);
+    return LAI_ERROR_NONE;
+}
+
+// Lazy handles only have room for a 32-bit reference to the scope that they were created in.
+// Such scopes are entered into a table once; the node remembers its index. Indices consist of
+// the position in the table plus one and the entry's tag. Entries of uninstalled scopes are
+// recycled with a new tag, such that stale indices no longer match.
+#define LAI_LAZY_SCOPE_POSITION_BITS 20
+#define LAI_LAZY_SCOPE_POSITION_MASK ((UINT32_C(1) << LAI_LAZY_SCOPE_POSITION_BITS) - 1)
+#define LAI_LAZY_SCOPE_TAG_MASK (UINT32_MAX >> LAI_LAZY_SCOPE_POSITION_BITS)
+
+uint32_t lai_ns_intern_lazy_scope(lai_nsnode_t *node) {
+    struct lai_instance *instance = lai_current_instance();
+
+    if (node->lazy_scope)
+        return node->lazy_scope;
+
+    uint32_t position = instance->lazy_scopes_free;
+    if (position) {
+        instance->lazy_scopes_free = instance->lazy_scopes[position - 1].next_free;
+    } else {
+        if (instance->lazy_scopes_size == instance->lazy_scopes_capacity) {
+            size_t new_capacity = instance->lazy_scopes_capacity * 2;
+            if (!new_capacity)
+                new_capacity = 16;
+            size_t entry_size = sizeof(struct lai_lazy_scope);
+            struct lai_lazy_scope *new_array;
+            new_array = laihost_realloc(instance->lazy_scopes, entry_size * new_capacity,
+                                        entry_size * instance->lazy_scopes_capacity);
+            if (!new_array)
+                lai_panic("could not reallocate lazy scope table");
+            instance->lazy_scopes = new_array;
+            instance->lazy_scopes_capacity = new_capacity;
+        }
+        if (instance->lazy_scopes_size == LAI_LAZY_SCOPE_POSITION_MASK)
+            lai_panic("too many scopes in lazy scope table");
+        instance->lazy_scopes[instance->lazy_scopes_size].tag = 0;
+        position = ++instance->lazy_scopes_size;
+    }
+
+    struct lai_lazy_scope *entry = &instance->lazy_scopes[position - 1];
+    entry->node = node;
+    node->lazy_scope = (entry->tag << LAI_LAZY_SCOPE_POSITION_BITS) | position;
+    return node->lazy_scope;
+}
+
+// Called before a scope is uninstalled or freed.
+static void lai_ns_release_lazy_scope(lai_nsnode_t *node) {
+    struct lai_instance *instance = lai_current_instance();
+    if (!node->lazy_scope)
+        return;
+
+    uint32_t position = node->lazy_scope & LAI_LAZY_SCOPE_POSITION_MASK;
+    struct lai_lazy_scope *entry = &instance->lazy_scopes[position - 1];
+    LAI_ENSURE(entry->node == node);
+    entry->node = NULL;
+    entry->tag = (entry->tag + 1) & LAI_LAZY_SCOPE_TAG_MASK;
+    entry->next_free = instance->lazy_scopes_free;
+    instance->lazy_scopes_free = position;
+    node->lazy_scope = 0;
+}
+
+// Returns NULL if the scope was uninstalled in the meantime.
+lai_nsnode_t *lai_ns_get_lazy_scope(uint32_t index) {
+    struct lai_instance *instance = lai_current_instance();
+    uint32_t position = index & LAI_LAZY_SCOPE_POSITION_MASK;
+    LAI_ENSURE(position && position <= instance->lazy_scopes_size);
+    struct lai_lazy_scope *entry = &instance->lazy_scopes[position - 1];
+    if (entry->tag != index >> LAI_LAZY_SCOPE_POSITION_BITS)
+        return NULL;
+    return entry->node;
+}
+
+// Helpers such as the _PRT walkers convert the same package elements to handles over and over.
+// As resolution only depends on the namespace, the result is cached until ns_generation changes.
+// Method-local nodes are not covered by ns_generation; while a method runs, names in its scope
+// are always resolved from scratch.
+lai_nsnode_t *lai_ns_resolve_lazy_handle(lai_variable_t *object) {
+    struct lai_instance *instance = lai_current_instance();
+    LAI_ENSURE(object->type == LAI_LAZY_HANDLE);
+
+    // If the scope is gone, only absolute names (and names in the root) can still be resolved.
+    lai_nsnode_t *scope = lai_ns_get_lazy_scope(object->unres_scope);
+    int cacheable = scope && !(scope->type == LAI_NAMESPACE_METHOD && scope->mth_invocation);
+    if (!scope)
+        scope = instance->root_node;
+
+    uintptr_t key = (uintptr_t)object->unres_aml;
+    struct lai_lazy_cache_entry *entry =
+        &instance->lazy_cache[(key ^ (key >> 6) ^ (key >> 12)) % LAI_LAZY_CACHE_SIZE];
+    if (cacheable && entry->generation && entry->generation == instance->ns_generation
+        && entry->aml == object->unres_aml && entry->scope == object->unres_scope)
+        return entry->handle;
+
+    struct lai_amlname amln;
+    lai_amlname_parse(&amln, object->unres_aml);
+    lai_nsnode_t *handle = lai_do_resolve(scope, &amln);
+    if (!handle)
+        lai_panic("undefined reference %s", lai_stringify_amlname(&amln));
+
+    if (cacheable) {
+        entry->aml = object->unres_aml;
+        entry->scope = object->unres_scope;
+        entry->generation = instance->ns_generation;
+        entry->handle = handle;
+    }
+    return handle;
+}
+
 lai_nsnode_t *lai_ns_get_root() {
     return lai_current_instance()->root_node;
 }
@@ -139,8 +327,13 @@ lai_nsnode_t *lai_ns_get_parent(lai_nsnode_t *node) {
     return node->parent;
 }
 
-lai_nsnode_t *lai_ns_get_child(lai_nsnode_t *parent, const char *name) {
-    int h = lai_hash_string(name, 4);
+static lai_nsnode_t *lai_ns_get_child_hashed(lai_nsnode_t *parent, const char *name, int h) {
+    if (parent->type == LAI_NAMESPACE_METHOD && parent->mth_invocation) {
+        lai_nsnode_t *local = lai_ns_get_local(parent->mth_invocation, name);
+        if (local)
+            return local;
+    }
+
     struct lai_hashtable_chain chain = LAI_HASHTABLE_CHAIN_INITIALIZER;
     while (!lai_hashtable_chain_advance(&parent->children, h, &chain)) {
         lai_nsnode_t *child = lai_hashtable_chain_get(&parent->children, h, &chain);
@@ -150,6 +343,10 @@ lai_nsnode_t *lai_ns_get_child(lai_nsnode_t *parent, const char *name) {
     return NULL;
 }
 
+lai_nsnode_t *lai_ns_get_child(lai_nsnode_t *parent, const char *name) {
+    return lai_ns_get_child_hashed(parent, name, lai_hash_string(name, 4));
+}
+
 size_t lai_amlname_parse(struct lai_amlname *amln, const void *data) {
     amln->is_absolute = 0;
     amln->height = 0;
@@ -503,7 +700,7 @@ void lai_create_namespace(void) {
 
     void *dsdt_amls = lai_load_table(dsdt_table, 0);
     lai_init_state(&state);
-    lai_populate(root_node, dsdt_amls, &state);
+    lai_exec_populate(root_node, dsdt_amls, &state);
     lai_finalize_state(&state);
 
     // Load all SSDTs.
@@ -512,7 +709,7 @@ void lai_create_namespace(void) {
     while ((ssdt_table = laihost_scan("SSDT", index))) {
         void *ssdt_amls = lai_load_table(ssdt_table, index);
         lai_init_state(&state);
-        lai_populate(root_node, ssdt_amls, &state);
+        lai_exec_populate(root_node, ssdt_amls, &state);
         lai_finalize_state(&state);
         index++;
     }
@@ -524,11 +721,17 @@ void lai_create_namespace(void) {
     while ((psdt_table = laihost_scan("PSDT", index))) {
         void *psdt_amls = lai_load_table(psdt_table, index);
         lai_init_state(&state);
-        lai_populate(root_node, psdt_amls, &state);
+        lai_exec_populate(root_node, psdt_amls, &state);
         lai_finalize_state(&state);
         index++;
     }
 
+    // Handlers may have been installed before the regions existed.
+    lai_connect_opregions();
+
+    if (instance->verify_enabled)
+        lai_verify_namespace();
+
     lai_debug("ACPI namespace created, total of %ld predefined objects.", instance->ns_size);
 }
 
@@ -609,6 +812,88 @@ lai_nsnode_t *lai_resolve_path(lai_nsnode_t *ctx_handle, const char *path) {
     return current;
 }
 
+lai_api_error_t lai_compile_path(lai_path_t *path, const char *str) {
+    memset(path, 0, sizeof(lai_path_t));
+
+    if (*str == '\\') {
+        path->is_absolute = 1;
+        str++;
+    } else {
+        while (*str == '^') {
+            path->height++;
+            str++;
+        }
+    }
+
+    if (!(*str))
+        return LAI_ERROR_NONE;
+
+    for (;;) {
+        if (path->num_segments == LAI_PATH_MAX_SEGMENTS)
+            return LAI_ERROR_OUT_OF_BOUNDS;
+
+        char segment[4];
+        int k;
+        for (k = 0; k < 4; k++) {
+            // Unlike lai_is_name(), do not accept prefix characters (which include '.').
+            char c = *str;
+            if (!((c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_'))
+                break;
+            segment[k] = *(str++);
+        }
+        if (!k)
+            return LAI_ERROR_ILLEGAL_ARGUMENTS;
+        while (k < 4)
+            segment[k++] = '_';
+
+        memcpy(&path->segments[path->num_segments], segment, 4);
+        path->hashes[path->num_segments] = lai_hash_string(segment, 4);
+        path->num_segments++;
+
+        if (!(*str))
+            break;
+        if (*str != '.')
+            return LAI_ERROR_ILLEGAL_ARGUMENTS;
+        str++;
+    }
+
+    return LAI_ERROR_NONE;
+}
+
+// Same as lai_resolve_path() but does not need to parse the path or hash its segments.
+lai_nsnode_t *lai_resolve_compiled_path(lai_nsnode_t *ctx_handle, const lai_path_t *path) {
+    lai_nsnode_t *current = ctx_handle;
+    if (!current)
+        current = lai_current_instance()->root_node;
+
+    if (path->is_absolute) {
+        while (current->parent)
+            current = current->parent;
+        LAI_ENSURE(current->type == LAI_NAMESPACE_ROOT);
+    } else {
+        for (int i = 0; i < path->height; i++) {
+            if (!current->parent) {
+                LAI_ENSURE(current->type == LAI_NAMESPACE_ROOT);
+                break;
+            }
+            current = current->parent;
+        }
+    }
+
+    for (int i = 0; i < path->num_segments; i++) {
+        current = lai_ns_get_child_hashed(current, (const char *)&path->segments[i],
+                                          path->hashes[i]);
+        if (!current)
+            return NULL;
+        if (current->type == LAI_NAMESPACE_ALIAS) {
+            current = current->al_target;
+            LAI_ENSURE(current->type != LAI_NAMESPACE_ALIAS);
+        }
+    }
+
+    return current;
+}
+
 lai_nsnode_t *lai_resolve_search(lai_nsnode_t *ctx_handle, const char *segment) {
     lai_nsnode_t *current = ctx_handle;
     LAI_ENSURE(current);
@@ -669,7 +954,7 @@ int lai_check_device_pnp_id(lai_nsnode_t *dev, lai_variable_t *pnp_id, lai_state
             ret = 0;
         }
     } else if (id.type == LAI_STRING && pnp_id->type == LAI_STRING) {
-        if (!lai_strcmp(lai_exec_string_access(&id), lai_exec_string_access(pnp_id))) {
+        if (!lai_strcmp(lai_exec_string_view(&id), lai_exec_string_view(pnp_id))) {
             ret = 0;
         }
     }
@@ -710,6 +995,102 @@ lai_api_error_t lai_ns_override_notify(lai_nsnode_t *node,
     return LAI_ERROR_NONE;
 }
 
+// Delivers a single Notify() to the host and to the node's override.
+static void lai_deliver_notify(lai_nsnode_t *node, uint64_t value) {
+    if (laihost_handle_global_notify)
+        laihost_handle_global_notify(node, value);
+
+    if (node->notify_override) {
+        lai_api_error_t error;
+        error = node->notify_override(node, value, node->notify_userptr);
+        // TODO: for now, there no errors defined.
+        //       Add a way for the host to signal Notify() failure.
+        LAI_ENSURE(!error);
+    } else {
+        LAI_CLEANUP_FREE_STRING char *path = lai_stringify_node_path(node);
+        lai_warn("Unhandled Notify(%s, 0x%lx)", path, value);
+    }
+}
+
+void lai_ns_notify(lai_nsnode_t *node, uint64_t value) {
+    struct lai_instance *instance = lai_current_instance();
+
+    if (!(instance->notify_flags & LAI_NOTIFY_QUEUE)) {
+        lai_deliver_notify(node, value);
+        return;
+    }
+
+    // Coalesce duplicates: the host only needs to see each (node, value) pair once per batch.
+    for (size_t i = 0; i < instance->notify_queue_size; i++) {
+        if (instance->notify_queue[i].node == node && instance->notify_queue[i].value == value)
+            return;
+    }
+
+    if (instance->notify_queue_size == instance->notify_queue_capacity) {
+        size_t new_capacity = instance->notify_queue_capacity * 2;
+        if (!new_capacity)
+            new_capacity = 8;
+
+        size_t entry_size = sizeof(struct lai_notify_entry);
+        struct lai_notify_entry *new_queue;
+        new_queue = laihost_realloc(instance->notify_queue, entry_size * new_capacity,
+                                    entry_size * instance->notify_queue_capacity);
+        if (!new_queue) {
+            // Losing a Notify() is worse than delivering it early.
+            lai_warn("could not grow Notify() queue, delivering synchronously");
+            lai_deliver_notify(node, value);
+            return;
+        }
+        instance->notify_queue = new_queue;
+        instance->notify_queue_capacity = new_capacity;
+    }
+
+    instance->notify_queue[instance->notify_queue_size++] =
+        (struct lai_notify_entry){.node = node, .value = value};
+}
+
+void lai_ns_cancel_notify(lai_nsnode_t *node) {
+    struct lai_instance *instance = lai_current_instance();
+    size_t n = 0;
+    for (size_t i = 0; i < instance->notify_queue_size; i++) {
+        if (instance->notify_queue[i].node != node)
+            instance->notify_queue[n++] = instance->notify_queue[i];
+    }
+    instance->notify_queue_size = n;
+}
+
+size_t lai_drain_notify_queue(void) {
+    struct lai_instance *instance = lai_current_instance();
+    size_t n = 0;
+
+    // Handlers may evaluate AML (and thus queue further notifications) while we deliver,
+    // so detach the current batch before running any of them.
+    while (instance->notify_queue_size) {
+        struct lai_notify_entry *queue = instance->notify_queue;
+        size_t size = instance->notify_queue_size;
+        size_t capacity = instance->notify_queue_capacity;
+        instance->notify_queue = NULL;
+        instance->notify_queue_size = 0;
+        instance->notify_queue_capacity = 0;
+
+        for (size_t i = 0; i < size; i++)
+            lai_deliver_notify(queue[i].node, queue[i].value);
+        n += size;
+
+        laihost_free(queue, sizeof(struct lai_notify_entry) * capacity);
+    }
+    return n;
+}
+
+void lai_enable_notify_queue(int flags) {
+    struct lai_instance *instance = lai_current_instance();
+
+    // Do not drop notifications that were queued under the old mode.
+    if (!(flags & LAI_NOTIFY_QUEUE))
+        lai_drain_notify_queue();
+    instance->notify_flags = flags;
+}
+
 lai_api_error_t lai_ns_override_opregion(lai_nsnode_t *node,
                                          const struct lai_opregion_override *override,
                                          void *userptr) {
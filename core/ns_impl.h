@@ -15,5 +15,19 @@ lai_nsnode_t *lai_create_nsnode_or_die(void);
 lai_api_error_t lai_install_nsnode(lai_nsnode_t *node);
 void lai_uninstall_nsnode(lai_nsnode_t *node);
 
+// Maps scopes of LAI_LAZY_HANDLE objects to 32-bit indices and back. Indices of scopes that
+// were uninstalled in the meantime map to NULL.
+uint32_t lai_ns_intern_lazy_scope(lai_nsnode_t *node);
+lai_nsnode_t *lai_ns_get_lazy_scope(uint32_t index);
+
+// Resolves a LAI_LAZY_HANDLE. Panics if the name is undefined.
+lai_nsnode_t *lai_ns_resolve_lazy_handle(lai_variable_t *object);
+
+// Delivers a Notify() or queues it, depending on lai_enable_notify_queue().
+void lai_ns_notify(lai_nsnode_t *node, uint64_t value);
+
+// Drops queued Notify() operations on a node that is about to be uninstalled or freed.
+void lai_ns_cancel_notify(lai_nsnode_t *node);
+
 // Sets the name and parent of a namespace node.
 size_t lai_resolve_new_node(lai_nsnode_t *node, lai_nsnode_t *ctx_handle, void *data);
@@ -8,20 +8,56 @@
 #include "aml_opcodes.h"
 #include "exec_impl.h"
 #include "libc.h"
+#include "ns_impl.h"
+#include "profile.h"
+
+struct lai_storage *lai_create_storage(size_t size) {
+    lai_profile_alloc();
+    struct lai_storage *storage = laihost_malloc(sizeof(struct lai_storage) + size);
+    if (!storage)
+        return NULL;
+    storage->rc = 1;
+    storage->size = size;
+    memset(lai_storage_data(storage), 0, size);
+    return storage;
+}
+
+// Allocates the head of a string or buffer. If the contents fit, an inline area for them is
+// allocated directly after the head. Otherwise, the caller has to allocate a struct lai_storage.
+static void *lai_alloc_head(size_t head_size, size_t content_size, unsigned int *inline_size) {
+    size_t n = content_size <= LAI_SMALL_OBJECT_SIZE ? LAI_SMALL_OBJECT_SIZE : 0;
+    lai_profile_alloc();
+    void *head = laihost_malloc(head_size + n);
+    if (!head)
+        return NULL;
+    memset((char *)head + head_size, 0, n);
+    *inline_size = n;
+    return head;
+}
 
 lai_api_error_t lai_create_string(lai_variable_t *object, size_t length) {
-    object->type = LAI_STRING;
-    object->string_ptr = laihost_malloc(sizeof(struct lai_string_head));
-    if (!object->string_ptr)
-        return LAI_ERROR_OUT_OF_MEMORY;
-    object->string_ptr->rc = 1;
-    object->string_ptr->content = laihost_malloc(length + 1);
-    object->string_ptr->capacity = length + 1;
-    if (!object->string_ptr->content) {
-        laihost_free(object->string_ptr, sizeof(struct lai_string_head));
+    unsigned int inline_size;
+    struct lai_string_head *head =
+        lai_alloc_head(sizeof(struct lai_string_head), length + 1, &inline_size);
+    if (!head)
         return LAI_ERROR_OUT_OF_MEMORY;
+    head->rc = 1;
+    head->inline_size = inline_size;
+    head->capacity = length + 1;
+    if (inline_size) {
+        head->storage = NULL;
+        head->content = (char *)(head + 1);
+    } else {
+        head->storage = lai_create_storage(length + 1);
+        if (!head->storage) {
+            laihost_free(head, sizeof(struct lai_string_head));
+            return LAI_ERROR_OUT_OF_MEMORY;
+        }
+        head->content = lai_storage_data(head->storage);
     }
-    memset(object->string_ptr->content, 0, length + 1);
+
+    object->type = LAI_STRING;
+    object->string_ptr = head;
     return LAI_ERROR_NONE;
 }
 
@@ -35,48 +71,209 @@ lai_api_error_t lai_create_c_string(lai_variable_t *object, const char *s) {
 }
 
 lai_api_error_t lai_create_buffer(lai_variable_t *object, size_t size) {
+    unsigned int inline_size;
+    struct lai_buffer_head *head =
+        lai_alloc_head(sizeof(struct lai_buffer_head), size, &inline_size);
+    if (!head)
+        return LAI_ERROR_OUT_OF_MEMORY;
+    head->rc = 1;
+    head->inline_size = inline_size;
+    head->size = size;
+    if (inline_size) {
+        head->storage = NULL;
+        head->content = (uint8_t *)(head + 1);
+    } else {
+        head->storage = lai_create_storage(size);
+        if (!head->storage) {
+            laihost_free(head, sizeof(struct lai_buffer_head));
+            return LAI_ERROR_OUT_OF_MEMORY;
+        }
+        head->content = lai_storage_data(head->storage);
+    }
+
+    object->type = LAI_BUFFER;
+    object->buffer_ptr = head;
+    return LAI_ERROR_NONE;
+}
+
+lai_api_error_t lai_create_borrowed_buffer(lai_variable_t *object, const uint8_t *data,
+                                           size_t size) {
+    lai_profile_alloc();
+    struct lai_buffer_head *head = laihost_malloc(sizeof(struct lai_buffer_head));
+    if (!head)
+        return LAI_ERROR_OUT_OF_MEMORY;
+    head->rc = 1;
+    head->inline_size = 0;
+    head->size = size;
+    head->content = (uint8_t *)data;
+    head->storage = NULL;
+
     object->type = LAI_BUFFER;
-    object->buffer_ptr = laihost_malloc(sizeof(struct lai_buffer_head));
-    if (!object->buffer_ptr)
+    object->buffer_ptr = head;
+    return LAI_ERROR_NONE;
+}
+
+lai_api_error_t lai_create_pkg(lai_variable_t *object, size_t n) {
+    object->type = LAI_PACKAGE;
+    lai_profile_alloc();
+    object->pkg_ptr = laihost_malloc(sizeof(struct lai_pkg_head));
+    if (!object->pkg_ptr)
         return LAI_ERROR_OUT_OF_MEMORY;
-    object->buffer_ptr->rc = 1;
-    object->buffer_ptr->size = size;
-    object->buffer_ptr->content = laihost_malloc(size);
-    if (!object->buffer_ptr->content) {
-        laihost_free(object->buffer_ptr, sizeof(struct lai_buffer_head));
+    object->pkg_ptr->rc = 1;
+    object->pkg_ptr->size = n;
+    object->pkg_ptr->packed = 0;
+    object->pkg_ptr->storage = lai_create_storage(n * sizeof(lai_variable_t));
+    if (!object->pkg_ptr->storage) {
+        laihost_free(object->pkg_ptr, sizeof(struct lai_pkg_head));
         return LAI_ERROR_OUT_OF_MEMORY;
     }
-    memset(object->buffer_ptr->content, 0, size);
+    object->pkg_ptr->elems = lai_storage_data(object->pkg_ptr->storage);
     return LAI_ERROR_NONE;
 }
 
-lai_api_error_t lai_create_pkg(lai_variable_t *object, size_t n) {
+lai_api_error_t lai_create_packed_pkg(lai_variable_t *object, size_t n) {
     object->type = LAI_PACKAGE;
+    lai_profile_alloc();
     object->pkg_ptr = laihost_malloc(sizeof(struct lai_pkg_head));
     if (!object->pkg_ptr)
         return LAI_ERROR_OUT_OF_MEMORY;
     object->pkg_ptr->rc = 1;
     object->pkg_ptr->size = n;
-    object->pkg_ptr->elems = laihost_malloc(n * sizeof(lai_variable_t));
-    if (!object->pkg_ptr->elems) {
+    object->pkg_ptr->packed = 1;
+    object->pkg_ptr->storage = lai_create_storage(n * sizeof(uint64_t));
+    if (!object->pkg_ptr->storage) {
         laihost_free(object->pkg_ptr, sizeof(struct lai_pkg_head));
         return LAI_ERROR_OUT_OF_MEMORY;
     }
-    memset(object->pkg_ptr->elems, 0, n * sizeof(lai_variable_t));
+    object->pkg_ptr->packed_elems = lai_storage_data(object->pkg_ptr->storage);
     return LAI_ERROR_NONE;
 }
 
+void lai_exec_string_unshare(struct lai_string_head *head) {
+    if (!head->storage || head->storage->rc == 1)
+        return;
+    if (head->capacity <= head->inline_size) {
+        memcpy(head + 1, head->content, head->capacity);
+        lai_release_storage(head->storage);
+        head->storage = NULL;
+        head->content = (char *)(head + 1);
+        return;
+    }
+    struct lai_storage *storage = lai_create_storage(head->capacity);
+    if (!storage)
+        lai_panic("could not allocate memory to unshare string");
+    memcpy(lai_storage_data(storage), head->content, head->capacity);
+    lai_release_storage(head->storage);
+    head->storage = storage;
+    head->content = lai_storage_data(storage);
+}
+
+void lai_exec_buffer_unshare(struct lai_buffer_head *head) {
+    // Inline contents are never shared, while borrowed ones always need to be copied.
+    if (head->storage ? head->storage->rc == 1 : head->inline_size)
+        return;
+    if (head->size <= head->inline_size) {
+        memcpy(head + 1, head->content, head->size);
+        lai_release_storage(head->storage);
+        head->storage = NULL;
+        head->content = (uint8_t *)(head + 1);
+        return;
+    }
+    struct lai_storage *storage = lai_create_storage(head->size);
+    if (!storage)
+        lai_panic("could not allocate memory to unshare buffer");
+    memcpy(lai_storage_data(storage), head->content, head->size);
+    if (head->storage)
+        lai_release_storage(head->storage);
+    head->storage = storage;
+    head->content = lai_storage_data(storage);
+}
+
+void lai_exec_pkg_unshare(struct lai_pkg_head *head) {
+    if (head->storage->rc == 1)
+        return;
+    if (head->packed) {
+        struct lai_storage *storage = lai_create_storage(head->size * sizeof(uint64_t));
+        if (!storage)
+            lai_panic("could not allocate memory to unshare package");
+        memcpy(lai_storage_data(storage), head->packed_elems, head->size * sizeof(uint64_t));
+        lai_release_storage(head->storage);
+        head->storage = storage;
+        head->packed_elems = lai_storage_data(storage);
+        return;
+    }
+    struct lai_storage *storage = lai_create_storage(head->size * sizeof(lai_variable_t));
+    if (!storage)
+        lai_panic("could not allocate memory to unshare package");
+    // The elements themselves are copy-on-write, too.
+    lai_variable_t *elems = lai_storage_data(storage);
+    for (unsigned int i = 0; i < head->size; i++)
+        lai_obj_clone(&elems[i], &head->elems[i]);
+    lai_release_pkg_storage(head->storage);
+    head->storage = storage;
+    head->elems = elems;
+}
+
+// As this allocates new storage anyway, it also unshares the package.
+void lai_exec_pkg_unpack(struct lai_pkg_head *head) {
+    if (!head->packed)
+        return;
+    struct lai_storage *storage = lai_create_storage(head->size * sizeof(lai_variable_t));
+    if (!storage)
+        lai_panic("could not allocate memory to unpack package");
+    lai_variable_t *elems = lai_storage_data(storage);
+    for (unsigned int i = 0; i < head->size; i++) {
+        elems[i].type = LAI_INTEGER;
+        elems[i].integer = head->packed_elems[i];
+    }
+    lai_release_storage(head->storage);
+    head->storage = storage;
+    head->elems = elems;
+    head->packed = 0;
+}
+
+// Converts a package that only contains integers to packed form.
+// Returns false if the package contains other objects.
+static int lai_pkg_pack(struct lai_pkg_head *head) {
+    if (head->packed)
+        return 1;
+    for (unsigned int i = 0; i < head->size; i++) {
+        if (head->elems[i].type != LAI_INTEGER)
+            return 0;
+    }
+    struct lai_storage *storage = lai_create_storage(head->size * sizeof(uint64_t));
+    if (!storage)
+        return 0;
+    uint64_t *packed_elems = lai_storage_data(storage);
+    for (unsigned int i = 0; i < head->size; i++)
+        packed_elems[i] = head->elems[i].integer;
+    lai_release_pkg_storage(head->storage);
+    head->storage = storage;
+    head->packed_elems = packed_elems;
+    head->packed = 1;
+    return 1;
+}
+
 lai_api_error_t lai_obj_resize_string(lai_variable_t *object, size_t length) {
     if (object->type != LAI_STRING)
         return LAI_ERROR_TYPE_MISMATCH;
-    if (length > lai_strlen(object->string_ptr->content)) {
-        char *new_content = laihost_malloc(length + 1);
-        if (!new_content)
+    struct lai_string_head *head = object->string_ptr;
+    if (length > lai_strlen(head->content)) {
+        // Inline contents can grow in place until they exhaust the inline area.
+        if (!head->storage && length + 1 <= head->inline_size) {
+            head->capacity = length + 1;
+            return LAI_ERROR_NONE;
+        }
+
+        struct lai_storage *storage = lai_create_storage(length + 1);
+        if (!storage)
             return LAI_ERROR_OUT_OF_MEMORY;
-        lai_strcpy(new_content, object->string_ptr->content);
-        laihost_free(object->string_ptr->content, object->string_ptr->capacity);
-        object->string_ptr->content = new_content;
-        object->string_ptr->capacity = length + 1;
+        lai_strcpy(lai_storage_data(storage), head->content);
+        if (head->storage)
+            lai_release_storage(head->storage);
+        head->storage = storage;
+        head->content = lai_storage_data(storage);
+        head->capacity = length + 1;
     }
     return LAI_ERROR_NONE;
 }
@@ -84,16 +281,23 @@ lai_api_error_t lai_obj_resize_string(lai_variable_t *object, size_t length) {
 lai_api_error_t lai_obj_resize_buffer(lai_variable_t *object, size_t size) {
     if (object->type != LAI_BUFFER)
         return LAI_ERROR_TYPE_MISMATCH;
-    if (size > object->buffer_ptr->size) {
-        uint8_t *new_content = laihost_malloc(size);
-        if (!new_content)
-            return LAI_ERROR_OUT_OF_MEMORY;
-        memset(new_content, 0, size);
-        memcpy(new_content, object->buffer_ptr->content, object->buffer_ptr->size);
-        laihost_free(object->buffer_ptr->content, object->buffer_ptr->size);
-        object->buffer_ptr->content = new_content;
+    struct lai_buffer_head *head = object->buffer_ptr;
+    if (size > head->size) {
+        if (!head->storage && size <= head->inline_size) {
+            // Inline contents can grow in place until they exhaust the inline area.
+            memset(head->content + head->size, 0, size - head->size);
+        } else {
+            struct lai_storage *storage = lai_create_storage(size);
+            if (!storage)
+                return LAI_ERROR_OUT_OF_MEMORY;
+            memcpy(lai_storage_data(storage), head->content, head->size);
+            if (head->storage)
+                lai_release_storage(head->storage);
+            head->storage = storage;
+            head->content = lai_storage_data(storage);
+        }
     }
-    object->buffer_ptr->size = size;
+    head->size = size;
     return LAI_ERROR_NONE;
 }
 
@@ -101,16 +305,27 @@ lai_api_error_t lai_obj_resize_pkg(lai_variable_t *object, size_t n) {
     if (object->type != LAI_PACKAGE)
         return LAI_ERROR_TYPE_MISMATCH;
     if (n <= object->pkg_ptr->size) {
-        for (unsigned int i = n; i < object->pkg_ptr->size; i++)
-            lai_var_finalize(&object->pkg_ptr->elems[i]);
+        lai_exec_pkg_unshare(object->pkg_ptr);
+        if (!object->pkg_ptr->packed) {
+            for (unsigned int i = n; i < object->pkg_ptr->size; i++)
+                lai_var_finalize(&object->pkg_ptr->elems[i]);
+        }
     } else {
-        struct lai_variable_t *new_elems = laihost_malloc(n * sizeof(lai_variable_t));
-        if (!new_elems)
+        // The new elements are uninitialized, which cannot be represented in packed form.
+        lai_exec_pkg_unpack(object->pkg_ptr);
+        struct lai_storage *storage = lai_create_storage(n * sizeof(lai_variable_t));
+        if (!storage)
             return LAI_ERROR_OUT_OF_MEMORY;
-        memset(new_elems, 0, n * sizeof(lai_variable_t));
-        for (unsigned int i = 0; i < object->pkg_ptr->size; i++)
-            lai_var_move(&new_elems[i], &object->pkg_ptr->elems[i]);
-        laihost_free(object->pkg_ptr->elems, object->pkg_ptr->size * sizeof(lai_variable_t));
+        lai_variable_t *new_elems = lai_storage_data(storage);
+        if (object->pkg_ptr->storage->rc > 1) {
+            for (unsigned int i = 0; i < object->pkg_ptr->size; i++)
+                lai_obj_clone(&new_elems[i], &object->pkg_ptr->elems[i]);
+        } else {
+            for (unsigned int i = 0; i < object->pkg_ptr->size; i++)
+                lai_var_move(&new_elems[i], &object->pkg_ptr->elems[i]);
+        }
+        lai_release_pkg_storage(object->pkg_ptr->storage);
+        object->pkg_ptr->storage = storage;
         object->pkg_ptr->elems = new_elems;
     }
     object->pkg_ptr->size = n;
@@ -153,15 +368,8 @@ enum lai_object_type lai_obj_get_type(lai_variable_t *object) {
 
         case LAI_HANDLE:
             return lai_object_type_of_node(object->handle);
-        case LAI_LAZY_HANDLE: {
-            struct lai_amlname amln;
-            lai_amlname_parse(&amln, object->unres_aml);
-
-            lai_nsnode_t *handle = lai_do_resolve(object->unres_ctx_handle, &amln);
-            if (!handle)
-                lai_panic("undefined reference %s", lai_stringify_amlname(&amln));
-            return lai_object_type_of_node(handle);
-        }
+        case LAI_LAZY_HANDLE:
+            return lai_object_type_of_node(lai_ns_resolve_lazy_handle(object));
         case 0:
             return LAI_TYPE_NONE;
         default:
@@ -191,21 +399,25 @@ lai_api_error_t lai_obj_get_pkg(lai_variable_t *object, size_t i, lai_variable_t
     return 0;
 }
 
+lai_api_error_t lai_obj_get_pkg_u64_array(lai_variable_t *object, const uint64_t **out,
+                                          size_t *n) {
+    if (object->type != LAI_PACKAGE)
+        return LAI_ERROR_TYPE_MISMATCH;
+    if (!lai_pkg_pack(object->pkg_ptr))
+        return LAI_ERROR_TYPE_MISMATCH;
+    *out = object->pkg_ptr->packed_elems;
+    *n = object->pkg_ptr->size;
+    return LAI_ERROR_NONE;
+}
+
 lai_api_error_t lai_obj_get_handle(lai_variable_t *object, lai_nsnode_t **out) {
     switch (object->type) {
         case LAI_HANDLE:
             *out = object->handle;
             return LAI_ERROR_NONE;
-        case LAI_LAZY_HANDLE: {
-            struct lai_amlname amln;
-            lai_amlname_parse(&amln, object->unres_aml);
-
-            lai_nsnode_t *handle = lai_do_resolve(object->unres_ctx_handle, &amln);
-            if (!handle)
-                lai_panic("undefined reference %s", lai_stringify_amlname(&amln));
-            *out = handle;
+        case LAI_LAZY_HANDLE:
+            *out = lai_ns_resolve_lazy_handle(object);
             return LAI_ERROR_NONE;
-        }
 
         default:
             lai_warn("lai_obj_get_handle() expects a handle type, not a value of type %d",
@@ -259,7 +471,7 @@ lai_api_error_t lai_mutate_buffer(lai_variable_t *target, lai_variable_t *object
             if (copy_size > buffer_size)
                 copy_size = buffer_size;
             memset(lai_exec_buffer_access(target), 0, buffer_size);
-            memcpy(lai_exec_buffer_access(target), lai_exec_buffer_access(object), copy_size);
+            memcpy(lai_exec_buffer_access(target), lai_exec_buffer_view(object), copy_size);
             break;
         }
 
@@ -276,12 +488,12 @@ lai_api_error_t lai_mutate_buffer(lai_variable_t *target, lai_variable_t *object
             break;
         }
         case LAI_STRING: {
-            size_t copy_size = lai_strlen(lai_exec_string_access(object)) + 1;
+            size_t copy_size = lai_strlen(lai_exec_string_view(object)) + 1;
             size_t buffer_size = lai_exec_buffer_size(target);
             if (copy_size > buffer_size)
                 copy_size = buffer_size;
             memset(lai_exec_buffer_access(target), 0, buffer_size);
-            memcpy(lai_exec_buffer_access(target), lai_exec_string_access(object), copy_size);
+            memcpy(lai_exec_buffer_access(target), lai_exec_string_view(object), copy_size);
             break;
         }
 
@@ -297,7 +509,7 @@ lai_api_error_t lai_obj_to_string(lai_variable_t *out, lai_variable_t *object, s
     switch (object->type) {
         case LAI_TYPE_BUFFER: {
             size_t buffer_length = 0;
-            uint8_t *buffer = lai_exec_buffer_access(object);
+            const uint8_t *buffer = lai_exec_buffer_view(object);
             for (uint64_t i = 0; i < lai_exec_buffer_size(object); i++) {
                 if (buffer[i] == '\0')
                     break;
@@ -344,7 +556,7 @@ lai_api_error_t lai_obj_to_decimal_string(lai_variable_t *out, lai_variable_t *o
 
         case LAI_BUFFER: {
             size_t buffer_len = lai_exec_buffer_size(object);
-            uint8_t *buffer = lai_exec_buffer_access(object);
+            const uint8_t *buffer = lai_exec_buffer_view(object);
             lai_create_string(
                 out,
                 (buffer_len * 3)); // For every buffer byte we need 2 chars of number and a comma
@@ -391,7 +603,7 @@ lai_api_error_t lai_obj_to_hex_string(lai_variable_t *out, lai_variable_t *objec
 
         case LAI_BUFFER: {
             size_t buffer_len = lai_exec_buffer_size(object);
-            uint8_t *buffer = lai_exec_buffer_access(object);
+            const uint8_t *buffer = lai_exec_buffer_view(object);
             lai_create_string(
                 out,
                 (buffer_len
@@ -435,10 +647,10 @@ lai_api_error_t lai_mutate_string(lai_variable_t *target, lai_variable_t *object
     switch (object->type) {
         // No conversion necessary.
         case LAI_TYPE_STRING: {
-            size_t length = lai_strlen(lai_exec_string_access(object));
+            size_t length = lai_strlen(lai_exec_string_view(object));
             if (lai_obj_resize_string(target, length))
                 lai_panic("could not resize string in lai_mutate_string()");
-            lai_strcpy(lai_exec_string_access(target), lai_exec_string_access(object));
+            lai_strcpy(lai_exec_string_access(target), lai_exec_string_view(object));
             break;
         }
 
@@ -454,7 +666,7 @@ lai_api_error_t lai_mutate_string(lai_variable_t *target, lai_variable_t *object
         }
         case LAI_TYPE_BUFFER: {
             size_t length = lai_exec_buffer_size(object);
-            uint8_t *p = lai_exec_buffer_access(object);
+            const uint8_t *p = lai_exec_buffer_view(object);
 
             // Need space for '0x12 ' + one null-terminator.
             if (lai_obj_resize_string(target, 5 * length + 1))
@@ -487,7 +699,7 @@ lai_api_error_t lai_obj_to_integer(lai_variable_t *out, lai_variable_t *object)
 
         case LAI_BUFFER: {
             size_t buffer_len = lai_exec_buffer_size(object);
-            uint64_t *buffer = lai_exec_buffer_access(object);
+            const uint64_t *buffer = lai_exec_buffer_view(object);
 
             if (buffer_len < 8) {
                 lai_warn("lai_obj_to_integer() buffer shorter than 8 bytes");
@@ -509,7 +721,7 @@ lai_api_error_t lai_obj_to_integer(lai_variable_t *out, lai_variable_t *object)
 
         case LAI_STRING: {
             size_t string_len = lai_exec_string_length(object);
-            const char *string = lai_exec_string_access(object);
+            const char *string = lai_exec_string_view(object);
 
             uint64_t integer = 0;
 
@@ -639,7 +851,7 @@ lai_api_error_t lai_mutate_integer(lai_variable_t *target, lai_variable_t *objec
             break;
 
         case LAI_STRING: {
-            const char *s = lai_exec_string_access(object);
+            const char *s = lai_exec_string_view(object);
             LAI_ENSURE(target->type == LAI_INTEGER);
             target->integer = 0;
 
@@ -666,7 +878,7 @@ lai_api_error_t lai_mutate_integer(lai_variable_t *target, lai_variable_t *objec
             size_t copy_size = lai_exec_buffer_size(object);
             if (copy_size > 8)
                 copy_size = 8;
-            memcpy(&target->integer, lai_exec_buffer_access(object), copy_size);
+            memcpy(&target->integer, lai_exec_buffer_view(object), copy_size);
             // TODO: bswap() if necessary.
             break;
         }
@@ -679,29 +891,108 @@ lai_api_error_t lai_mutate_integer(lai_variable_t *target, lai_variable_t *objec
     return LAI_ERROR_NONE;
 }
 
-// lai_clone_buffer(): Clones a buffer object
+// lai_clone_buffer(): Clones a buffer object. Large (or borrowed) contents are shared until
+// either copy is modified; small ones are copied right away.
 static void lai_clone_buffer(lai_variable_t *dest, lai_variable_t *source) {
-    size_t size = lai_exec_buffer_size(source);
-    if (lai_create_buffer(dest, size) != LAI_ERROR_NONE)
+    struct lai_buffer_head *src_head = source->buffer_ptr;
+    if (!src_head->storage && src_head->inline_size) {
+        size_t size = lai_exec_buffer_size(source);
+        if (lai_create_buffer(dest, size) != LAI_ERROR_NONE)
+            lai_panic("unable to allocate memory for buffer object.");
+        memcpy(dest->buffer_ptr->content, src_head->content, size);
+        return;
+    }
+
+    lai_profile_alloc();
+    struct lai_buffer_head *head = laihost_malloc(sizeof(struct lai_buffer_head));
+    if (!head)
         lai_panic("unable to allocate memory for buffer object.");
-    memcpy(lai_exec_buffer_access(dest), lai_exec_buffer_access(source), size);
+    *head = *src_head;
+    head->rc = 1;
+    head->inline_size = 0;
+    if (head->storage)
+        lai_rc_ref(&head->storage->rc);
+
+    dest->type = LAI_BUFFER;
+    dest->buffer_ptr = head;
 }
 
-// lai_clone_string(): Clones a string object
+// lai_clone_string(): Clones a string object. Large contents are shared until either copy is
+// modified; small ones are copied right away.
 static void lai_clone_string(lai_variable_t *dest, lai_variable_t *source) {
-    size_t n = lai_exec_string_length(source);
-    if (lai_create_string(dest, n) != LAI_ERROR_NONE)
+    struct lai_string_head *src_head = source->string_ptr;
+    if (!src_head->storage) {
+        size_t n = lai_exec_string_length(source);
+        if (lai_create_string(dest, n) != LAI_ERROR_NONE)
+            lai_panic("unable to allocate memory for string object.");
+        memcpy(dest->string_ptr->content, src_head->content, n);
+        return;
+    }
+
+    lai_profile_alloc();
+    struct lai_string_head *head = laihost_malloc(sizeof(struct lai_string_head));
+    if (!head)
         lai_panic("unable to allocate memory for string object.");
-    memcpy(lai_exec_string_access(dest), lai_exec_string_access(source), n);
+    *head = *src_head;
+    head->rc = 1;
+    head->inline_size = 0;
+    lai_rc_ref(&head->storage->rc);
+
+    dest->type = LAI_STRING;
+    dest->string_ptr = head;
 }
 
-// lai_clone_package(): Clones a package object
+// Returns true if some (nested) element of the package is referenced from outside of the
+// package, e.g. by an Index() or a BufferField. Writes through such references must not
+// become visible in copies of the package, so its elements cannot be shared.
+static int lai_pkg_is_referenced(struct lai_pkg_head *head) {
+    if (head->packed)
+        return 0;
+    for (unsigned int i = 0; i < head->size; i++) {
+        lai_variable_t *elem = &head->elems[i];
+        switch (elem->type) {
+            case LAI_STRING:
+                if (elem->string_ptr->rc > 1)
+                    return 1;
+                break;
+            case LAI_BUFFER:
+                if (elem->buffer_ptr->rc > 1)
+                    return 1;
+                break;
+            case LAI_PACKAGE:
+                if (elem->pkg_ptr->rc > 1)
+                    return 1;
+                // Shared elements are never handed out, see lai_exec_pkg_var_load().
+                if (elem->pkg_ptr->storage->rc == 1 && lai_pkg_is_referenced(elem->pkg_ptr))
+                    return 1;
+                break;
+        }
+    }
+    return 0;
+}
+
+// lai_clone_package(): Clones a package object. If possible, the elements are shared until
+// either copy is modified.
 static void lai_clone_package(lai_variable_t *dest, lai_variable_t *src) {
     size_t n = src->pkg_ptr->size;
-    if (lai_create_pkg(dest, n) != LAI_ERROR_NONE)
+    if (src->pkg_ptr->storage->rc == 1 && lai_pkg_is_referenced(src->pkg_ptr)) {
+        if (lai_create_pkg(dest, n) != LAI_ERROR_NONE)
+            lai_panic("unable to allocate memory for package object.");
+        for (size_t i = 0; i < n; i++)
+            lai_obj_clone(&dest->pkg_ptr->elems[i], &src->pkg_ptr->elems[i]);
+        return;
+    }
+
+    lai_profile_alloc();
+    struct lai_pkg_head *head = laihost_malloc(sizeof(struct lai_pkg_head));
+    if (!head)
         lai_panic("unable to allocate memory for package object.");
-    for (size_t i = 0; i < n; i++)
-        lai_obj_clone(&dest->pkg_ptr->elems[i], &src->pkg_ptr->elems[i]);
+    *head = *src->pkg_ptr;
+    head->rc = 1;
+    lai_rc_ref(&head->storage->rc);
+
+    dest->type = LAI_PACKAGE;
+    dest->pkg_ptr = head;
 }
 
 extern void lai_swap_object(lai_variable_t *first, lai_variable_t *second); // from core/variable.c
@@ -753,6 +1044,7 @@ int lai_objecttype_obj(lai_variable_t *var) {
 int lai_objecttype_ns(lai_nsnode_t *node) {
     switch (node->type) {
         case LAI_NAMESPACE_NAME:
+            lai_exec_materialize_name(node);
             return lai_objecttype_obj(&node->object);
         case LAI_NAMESPACE_FIELD:
         case LAI_NAMESPACE_BANKFIELD:
@@ -816,8 +1108,8 @@ lai_api_error_t lai_obj_exec_match_op(int op, lai_variable_t *var, lai_variable_
                 return LAI_ERROR_UNEXPECTED_RESULT;
         }
     } else if (var->type == LAI_BUFFER || var->type == LAI_STRING) {
-        char *var_data = NULL;
-        char *obj_data = NULL;
+        const char *var_data = NULL;
+        const char *obj_data = NULL;
 
         size_t var_size = 0;
         size_t obj_size = 0;
@@ -827,8 +1119,8 @@ lai_api_error_t lai_obj_exec_match_op(int op, lai_variable_t *var, lai_variable_
             if (err != LAI_ERROR_NONE)
                 return err;
 
-            var_data = lai_exec_buffer_access(var);
-            obj_data = lai_exec_buffer_access(&compare_obj);
+            var_data = lai_exec_buffer_view(var);
+            obj_data = lai_exec_buffer_view(&compare_obj);
 
             var_size = lai_exec_buffer_size(var);
             obj_size = lai_exec_buffer_size(&compare_obj);
@@ -837,8 +1129,8 @@ lai_api_error_t lai_obj_exec_match_op(int op, lai_variable_t *var, lai_variable_
             if (err != LAI_ERROR_NONE)
                 return err;
 
-            var_data = lai_exec_string_access(var);
-            obj_data = lai_exec_string_access(&compare_obj);
+            var_data = lai_exec_string_view(var);
+            obj_data = lai_exec_string_view(&compare_obj);
 
             var_size = lai_exec_string_length(var);
             obj_size = lai_exec_string_length(&compare_obj);
@@ -13,37 +13,9 @@
 #include "exec_impl.h"
 #include "libc.h"
 #include "opregion.h"
-
-// this assumes little endian
-static void lai_buffer_put_at(uint8_t *buffer, uint64_t value, size_t bit_offset, size_t num_bits) {
-    size_t progress = 0;
-    while (progress < num_bits) {
-        size_t in_byte_offset = (bit_offset + progress) & 7;
-        size_t access_size = LAI_MIN(num_bits - progress, 8 - in_byte_offset);
-        size_t mask = (1 << access_size) - 1;
-
-        buffer[(bit_offset + progress) / 8] |= ((value >> progress) & mask) << in_byte_offset;
-
-        progress += access_size;
-    }
-}
-
-// this assumes little endian
-static uint64_t lai_buffer_get_at(uint8_t *buffer, size_t bit_offset, size_t num_bits) {
-    uint64_t value = 0;
-    size_t progress = 0;
-    while (progress < num_bits) {
-        size_t in_byte_offset = (bit_offset + progress) & 7;
-        size_t access_size = LAI_MIN(num_bits - progress, 8 - in_byte_offset);
-        size_t mask = (1 << access_size) - 1;
-
-        value |= (uint64_t)((buffer[(bit_offset + progress) / 8] >> in_byte_offset) & mask)
-                 << progress;
-
-        progress += access_size;
-    }
-    return value;
-}
+#include "profile.h"
+#include "trace.h"
+#include "util-bits.h"
 
 static size_t lai_calculate_access_width(lai_nsnode_t *field) {
     lai_nsnode_t *opregion = field->fld_region_node;
@@ -155,36 +127,79 @@ static void lai_get_pci_params(lai_nsnode_t *opregion, uint64_t *seg, uint64_t *
     }
 }
 
+// Returns the callbacks that handle accesses to an opregion (or NULL for the built-in ones).
+static const struct lai_opregion_override *lai_get_region_ops(lai_nsnode_t *opregion,
+                                                              void **userptr) {
+    if (opregion->op_override) {
+        *userptr = opregion->op_userptr;
+        return opregion->op_override;
+    }
+
+    struct lai_address_space_handler *handler =
+        &lai_current_instance()->address_space_handlers[opregion->op_address_space];
+    *userptr = handler->userptr;
+    return handler->ops;
+}
+
+// Writes that may hit a bank register invalidate the cached bank selections. Addresses are
+// compared instead of nodes, such that aliasing fields and regions are covered as well.
+static void lai_check_bank_write(lai_nsnode_t *opregion, uint64_t offset, size_t size) {
+    struct lai_instance *instance = lai_current_instance();
+    uint64_t address = opregion->op_base + offset;
+    for (int i = 0; i < instance->num_bank_registers; i++) {
+        struct lai_bank_register *reg = &instance->bank_registers[i];
+        if (reg->space == opregion->op_address_space && address < reg->end
+            && address + size > reg->start) {
+            lai_invalidate_bank_cache();
+            return;
+        }
+    }
+}
+
 typedef uint8_t __attribute__((aligned(1))) mmio8_t;
 typedef uint16_t __attribute__((aligned(1))) mmio16_t;
 typedef uint32_t __attribute__((aligned(1))) mmio32_t;
 typedef uint64_t __attribute__((aligned(1))) mmio64_t;
 
+// Without a handler, reads return zero and writes are dropped. This is only reported once per
+// address space (until a handler is installed), as methods access fields unit by unit.
+static void lai_warn_missing_handler(lai_nsnode_t *opregion) {
+    struct lai_address_space_handler *handler =
+        &lai_current_instance()->address_space_handlers[opregion->op_address_space];
+    if (handler->warned)
+        return;
+    handler->warned = 1;
+    lai_warn("no handler for address space %02x, reads return zero and writes are dropped",
+             opregion->op_address_space);
+}
+
 static uint64_t lai_perform_read(lai_nsnode_t *opregion, size_t access_size, size_t offset) {
     struct lai_instance *instance = lai_current_instance();
     uint64_t value = 0;
+    // Binary traces record the access once the value is known.
+    int trace = (instance->trace & LAI_TRACE_IO) && !instance->trace_ring;
 
-    if (opregion->op_override) {
-        if (instance->trace & LAI_TRACE_IO)
+    lai_profile_region_access(opregion->op_address_space);
+
+    void *userptr;
+    const struct lai_opregion_override *ops = lai_get_region_ops(opregion, &userptr);
+    if (ops) {
+        if (trace)
             lai_debug("lai_perform_read: %lu-bit read from overridden opregion at %lx (address "
                       "space %02u)",
                       access_size, opregion->op_base + offset, opregion->op_address_space);
         switch (access_size) {
             case 8:
-                value = opregion->op_override->readb(opregion->op_base + offset,
-                                                     opregion->op_userptr);
+                value = ops->readb(opregion->op_base + offset, userptr);
                 break;
             case 16:
-                value = opregion->op_override->readw(opregion->op_base + offset,
-                                                     opregion->op_userptr);
+                value = ops->readw(opregion->op_base + offset, userptr);
                 break;
             case 32:
-                value = opregion->op_override->readd(opregion->op_base + offset,
-                                                     opregion->op_userptr);
+                value = ops->readd(opregion->op_base + offset, userptr);
                 break;
             case 64:
-                value = opregion->op_override->readq(opregion->op_base + offset,
-                                                     opregion->op_userptr);
+                value = ops->readq(opregion->op_base + offset, userptr);
                 break;
             default:
                 lai_panic("invalid access size");
@@ -192,7 +207,7 @@ static uint64_t lai_perform_read(lai_nsnode_t *opregion, size_t access_size, siz
     } else {
         switch (opregion->op_address_space) {
             case ACPI_OPREGION_MEMORY: {
-                if (instance->trace & LAI_TRACE_IO)
+                if (trace)
                     lai_debug("lai_perform_read: %lu-bit read from MMIO at %lx", access_size,
                               opregion->op_base + offset);
                 if ((opregion->op_base + offset) & ((access_size / 8) - 1))
@@ -222,7 +237,7 @@ static uint64_t lai_perform_read(lai_nsnode_t *opregion, size_t access_size, siz
                 break;
             }
             case ACPI_OPREGION_IO: {
-                if (instance->trace & LAI_TRACE_IO)
+                if (trace)
                     lai_debug("lai_perform_read: %lu-bit read from I/O port at %lx", access_size,
                               opregion->op_base + offset);
                 if (!laihost_inb || !laihost_inw || !laihost_ind)
@@ -252,7 +267,7 @@ static uint64_t lai_perform_read(lai_nsnode_t *opregion, size_t access_size, siz
 
                 uint8_t slot = (uint8_t)(adr >> 16);
                 uint8_t fun = (uint8_t)(adr & 0xFF);
-                if (instance->trace & LAI_TRACE_IO)
+                if (trace)
                     lai_debug("lai_perform_read: %lu-bit read from PCI config of "
                               "%04lx:%02lx:%02x.%02x at %lx",
                               access_size, seg, bbn, slot, fun, opregion->op_base + offset);
@@ -273,37 +288,46 @@ static uint64_t lai_perform_read(lai_nsnode_t *opregion, size_t access_size, siz
                     default:
                         lai_panic("invalid access size");
                 }
+                break;
             }
+            default:
+                lai_warn_missing_handler(opregion);
         }
     }
 
+    if (instance->trace & LAI_TRACE_IO)
+        lai_trace_emit(LAI_TRACE_EVENT_IO_READ, access_size, offset, opregion, value);
     return value;
 }
 
 static void lai_perform_write(lai_nsnode_t *opregion, size_t access_size, size_t offset,
                               uint64_t value) {
     struct lai_instance *instance = lai_current_instance();
-    if (opregion->op_override) {
-        if (instance->trace & LAI_TRACE_IO)
+    int trace = (instance->trace & LAI_TRACE_IO)
+                && !lai_trace_emit(LAI_TRACE_EVENT_IO_WRITE, access_size, offset, opregion, value);
+
+    lai_profile_region_access(opregion->op_address_space);
+    lai_check_bank_write(opregion, offset, access_size / 8);
+
+    void *userptr;
+    const struct lai_opregion_override *ops = lai_get_region_ops(opregion, &userptr);
+    if (ops) {
+        if (trace)
             lai_debug("lai_perform_write: %lu-bit write of %lx to overridden opregion at %lx "
                       "(address space %02u)",
                       access_size, opregion->op_base + offset, value, opregion->op_address_space);
         switch (access_size) {
             case 8:
-                opregion->op_override->writeb(opregion->op_base + offset, value,
-                                              opregion->op_userptr);
+                ops->writeb(opregion->op_base + offset, value, userptr);
                 break;
             case 16:
-                opregion->op_override->writew(opregion->op_base + offset, value,
-                                              opregion->op_userptr);
+                ops->writew(opregion->op_base + offset, value, userptr);
                 break;
             case 32:
-                opregion->op_override->writed(opregion->op_base + offset, value,
-                                              opregion->op_userptr);
+                ops->writed(opregion->op_base + offset, value, userptr);
                 break;
             case 64:
-                opregion->op_override->writeq(opregion->op_base + offset, value,
-                                              opregion->op_userptr);
+                ops->writeq(opregion->op_base + offset, value, userptr);
                 break;
             default:
                 lai_panic("invalid access size");
@@ -311,7 +335,7 @@ static void lai_perform_write(lai_nsnode_t *opregion, size_t access_size, size_t
     } else {
         switch (opregion->op_address_space) {
             case ACPI_OPREGION_MEMORY: {
-                if (instance->trace & LAI_TRACE_IO)
+                if (trace)
                     lai_debug("lai_perform_write: %lu-bit write of %lx to MMIO at %lx", access_size,
                               value, opregion->op_base + offset);
                 if ((opregion->op_base + offset) & ((access_size / 8) - 1))
@@ -341,7 +365,7 @@ static void lai_perform_write(lai_nsnode_t *opregion, size_t access_size, size_t
                 break;
             }
             case ACPI_OPREGION_IO: {
-                if (instance->trace & LAI_TRACE_IO)
+                if (trace)
                     lai_debug("lai_perform_write: %lu-bit write of %lx to I/O port at %lx",
                               access_size, value, opregion->op_base + offset);
                 if (!laihost_outb || !laihost_inw || !laihost_outd)
@@ -371,7 +395,7 @@ static void lai_perform_write(lai_nsnode_t *opregion, size_t access_size, size_t
 
                 uint8_t slot = (uint8_t)(adr >> 16);
                 uint8_t fun = (uint8_t)(adr & 0xFF);
-                if (instance->trace & LAI_TRACE_IO)
+                if (trace)
                     lai_debug("lai_perform_write: %lu-bit write of %lx to PCI config of "
                               "%04lx:%02lx:%02x.%02x at %lx",
                               access_size, value, seg, bbn, slot, fun, opregion->op_base + offset);
@@ -392,56 +416,126 @@ static void lai_perform_write(lai_nsnode_t *opregion, size_t access_size, size_t
                     default:
                         lai_panic("invalid access size");
                 }
+                break;
             }
+            default:
+                lai_warn_missing_handler(opregion);
         }
     }
 }
 
-static uint64_t lai_perform_indexfield_read(lai_nsnode_t *opregion, size_t access_size,
-                                            size_t offset) {
-    (void)(access_size);
+// Index and data registers of an IndexField. Registers that are plain Fields covering exactly
+// one access unit are accessed through the region directly; others go through the field engine.
+struct lai_field_register {
+    lai_nsnode_t *field;
+    lai_nsnode_t *region; // NULL if the generic path is required.
+    size_t access_size;
+    uint64_t offset;
+};
 
-    LAI_ENSURE(opregion->type == LAI_NAMESPACE_INDEXFIELD);
+static void lai_prepare_field_register(struct lai_field_register *reg, lai_nsnode_t *field) {
+    reg->field = field;
+    reg->region = NULL;
 
-    lai_nsnode_t *index_field = opregion->fld_idxf_index_node;
-    lai_nsnode_t *data_field = opregion->fld_idxf_data_node;
+    if (field->type != LAI_NAMESPACE_FIELD)
+        return;
 
-    LAI_CLEANUP_VAR lai_variable_t index = LAI_VAR_INITIALIZER;
-    index.type = LAI_INTEGER;
-    index.integer = offset;
+    size_t access_size = lai_calculate_access_width(field);
+    if (field->fld_size != access_size || (field->fld_offset & (access_size - 1)))
+        return;
 
-    LAI_CLEANUP_VAR lai_variable_t dest = LAI_VAR_INITIALIZER;
+    reg->region = field->fld_region_node;
+    reg->access_size = access_size;
+    reg->offset = field->fld_offset / 8;
+}
 
-    lai_write_field(index_field, &index); // Write index register.
-    lai_read_field(&dest, data_field); // Read data register.
+static uint64_t lai_read_field_register(struct lai_field_register *reg) {
+    if (reg->region)
+        return lai_perform_read(reg->region, reg->access_size, reg->offset);
 
+    LAI_CLEANUP_VAR lai_variable_t dest = LAI_VAR_INITIALIZER;
+    lai_read_field(&dest, reg->field);
     LAI_ENSURE(dest.type == LAI_INTEGER);
     return dest.integer;
 }
 
-static void lai_perform_indexfield_write(lai_nsnode_t *opregion, size_t access_size, size_t offset,
-                                         uint64_t value) {
-    (void)(access_size);
-
-    lai_nsnode_t *index_field = opregion->fld_idxf_index_node;
-    lai_nsnode_t *data_field = opregion->fld_idxf_data_node;
-
-    LAI_CLEANUP_VAR lai_variable_t index = LAI_VAR_INITIALIZER;
-    index.type = LAI_INTEGER;
-    index.integer = offset;
+static void lai_write_field_register(struct lai_field_register *reg, uint64_t value) {
+    if (reg->region) {
+        lai_perform_write(reg->region, reg->access_size, reg->offset, value);
+        return;
+    }
 
     LAI_CLEANUP_VAR lai_variable_t src = LAI_VAR_INITIALIZER;
     src.type = LAI_INTEGER;
     src.integer = value;
+    lai_write_field(reg->field, &src);
+}
 
-    lai_write_field(index_field, &index); // Write index register.
-    lai_write_field(data_field, &src); // Write data register.
+static uint64_t lai_perform_indexfield_read(struct lai_field_register *index,
+                                            struct lai_field_register *data, size_t offset) {
+    lai_write_field_register(index, offset); // Write index register.
+    return lai_read_field_register(data); // Read data register.
+}
+
+static void lai_perform_indexfield_write(struct lai_field_register *index,
+                                         struct lai_field_register *data, size_t offset,
+                                         uint64_t value) {
+    lai_write_field_register(index, offset); // Write index register.
+    lai_write_field_register(data, value); // Write data register.
+}
+
+// Returns the callbacks if the field can be transferred by their bulk callbacks.
+// This is only the case if the field covers whole access units, so that the result does not
+// depend on the update rule and matches a sequence of scalar accesses. Bulk callbacks move
+// bytes, hence fields that require wider accesses (e.g., DWordAcc MMIO registers) never use them.
+static const struct lai_opregion_override *lai_get_bulk_ops(lai_nsnode_t *field,
+                                                            size_t access_size, int write,
+                                                            void **userptr) {
+    if (field->type != LAI_NAMESPACE_FIELD && field->type != LAI_NAMESPACE_BANKFIELD)
+        return NULL;
+    int access_type = field->fld_flags & 0xF;
+    if (access_type != FIELD_ANY_ACCESS && access_type != FIELD_BYTE_ACCESS)
+        return NULL;
+
+    const struct lai_opregion_override *ops = lai_get_region_ops(field->fld_region_node, userptr);
+    if (!ops)
+        return NULL;
+    if (write ? !ops->write_bulk : !ops->read_bulk)
+        return NULL;
+
+    if ((field->fld_offset & (access_size - 1)) || (field->fld_size & (access_size - 1)))
+        return NULL;
+    return ops;
 }
 
 void lai_read_field_internal(uint8_t *destination, lai_nsnode_t *field) {
     size_t access_size = lai_calculate_access_width(field);
 
+    void *userptr;
+    const struct lai_opregion_override *bulk_ops =
+        lai_get_bulk_ops(field, access_size, 0, &userptr);
+    if (bulk_ops) {
+        lai_nsnode_t *opregion = field->fld_region_node;
+        uint64_t address = opregion->op_base + field->fld_offset / 8;
+        lai_profile_region_access(opregion->op_address_space);
+        if ((lai_current_instance()->trace & LAI_TRACE_IO)
+            && !lai_trace_emit(LAI_TRACE_EVENT_IO_BULK_READ, 0, field->fld_offset / 8, opregion,
+                               field->fld_size / 8))
+            lai_debug("lai_read_field_internal: %lu-byte bulk read from overridden opregion at %lx "
+                      "(address space %02u)",
+                      field->fld_size / 8, address, opregion->op_address_space);
+        bulk_ops->read_bulk(address, destination, field->fld_size / 8, userptr);
+        return;
+    }
+
+    struct lai_field_register index, data;
+    if (field->type == LAI_NAMESPACE_INDEXFIELD) {
+        lai_prepare_field_register(&index, field->fld_idxf_index_node);
+        lai_prepare_field_register(&data, field->fld_idxf_data_node);
+    }
+
     uint64_t offset = (field->fld_offset & ~(access_size - 1)) / 8;
+    size_t size = (field->fld_size + 7) / 8;
 
     size_t progress = 0;
     while (progress < field->fld_size) {
@@ -453,14 +547,14 @@ void lai_read_field_internal(uint8_t *destination, lai_nsnode_t *field) {
         if (field->type == LAI_NAMESPACE_FIELD || field->type == LAI_NAMESPACE_BANKFIELD) {
             value = lai_perform_read(field->fld_region_node, access_size, offset);
         } else if (field->type == LAI_NAMESPACE_INDEXFIELD) {
-            value = lai_perform_indexfield_read(field, access_size, offset);
+            value = lai_perform_indexfield_read(&index, &data, offset);
         } else {
             lai_panic("Unknown field type in lai_write_field_internal %d", field->type);
         }
 
         value = (value >> bit_offset) & mask;
 
-        lai_buffer_put_at(destination, value, progress, access_bits);
+        lai_bits_put(destination, size, progress, access_bits, value);
 
         progress += access_bits;
         offset += access_size / 8;
@@ -470,7 +564,32 @@ void lai_read_field_internal(uint8_t *destination, lai_nsnode_t *field) {
 void lai_write_field_internal(uint8_t *source, lai_nsnode_t *field) {
     size_t access_size = lai_calculate_access_width(field);
 
+    void *userptr;
+    const struct lai_opregion_override *bulk_ops =
+        lai_get_bulk_ops(field, access_size, 1, &userptr);
+    if (bulk_ops) {
+        lai_nsnode_t *opregion = field->fld_region_node;
+        uint64_t address = opregion->op_base + field->fld_offset / 8;
+        lai_profile_region_access(opregion->op_address_space);
+        lai_check_bank_write(opregion, field->fld_offset / 8, field->fld_size / 8);
+        if ((lai_current_instance()->trace & LAI_TRACE_IO)
+            && !lai_trace_emit(LAI_TRACE_EVENT_IO_BULK_WRITE, 0, field->fld_offset / 8, opregion,
+                               field->fld_size / 8))
+            lai_debug("lai_write_field_internal: %lu-byte bulk write to overridden opregion at %lx "
+                      "(address space %02u)",
+                      field->fld_size / 8, address, opregion->op_address_space);
+        bulk_ops->write_bulk(address, source, field->fld_size / 8, userptr);
+        return;
+    }
+
+    struct lai_field_register index, data;
+    if (field->type == LAI_NAMESPACE_INDEXFIELD) {
+        lai_prepare_field_register(&index, field->fld_idxf_index_node);
+        lai_prepare_field_register(&data, field->fld_idxf_data_node);
+    }
+
     uint64_t offset = (field->fld_offset & ~(access_size - 1)) / 8;
+    size_t size = (field->fld_size + 7) / 8;
 
     size_t progress = 0;
     while (progress < field->fld_size) {
@@ -485,7 +604,7 @@ void lai_write_field_internal(uint8_t *source, lai_nsnode_t *field) {
             if (field->type == LAI_NAMESPACE_FIELD || field->type == LAI_NAMESPACE_BANKFIELD) {
                 value = lai_perform_read(field->fld_region_node, access_size, offset);
             } else if (field->type == LAI_NAMESPACE_INDEXFIELD) {
-                value = lai_perform_indexfield_read(field, access_size, offset);
+                value = lai_perform_indexfield_read(&index, &data, offset);
             } else {
                 lai_panic("Unknown field type in lai_write_field_internal %d", field->type);
             }
@@ -499,13 +618,13 @@ void lai_write_field_internal(uint8_t *source, lai_nsnode_t *field) {
 
         value &= ~mask;
 
-        uint64_t new_val = lai_buffer_get_at(source, progress, access_bits);
+        uint64_t new_val = lai_bits_get(source, size, progress, access_bits);
         value |= (new_val << bit_offset) & mask;
 
         if (field->type == LAI_NAMESPACE_FIELD || field->type == LAI_NAMESPACE_BANKFIELD) {
             lai_perform_write(field->fld_region_node, access_size, offset, value);
         } else if (field->type == LAI_NAMESPACE_INDEXFIELD) {
-            lai_perform_indexfield_write(field, access_size, offset, value);
+            lai_perform_indexfield_write(&index, &data, offset, value);
         } else {
             lai_panic("Unknown field type in lai_write_field_internal %d", field->type);
         }
@@ -527,13 +646,8 @@ void lai_read_field(lai_variable_t *destination, lai_nsnode_t *field) {
         memset(buf, 0, bytes);
         lai_read_field_internal(buf, field);
 
-        uint64_t value = 0;
-        for (size_t i = 0; i < bytes; i++) {
-            value |= (uint64_t)buf[i] << (i * 8);
-        }
-
         var.type = LAI_INTEGER;
-        var.integer = value;
+        var.integer = lai_bits_get(buf, bytes, 0, bytes * 8);
     }
 
     lai_var_move(destination, &var);
@@ -558,21 +672,70 @@ void lai_write_field(lai_nsnode_t *field, lai_variable_t *source) {
     }
 }
 
-void lai_read_bankfield(lai_variable_t *destination, lai_nsnode_t *field) {
+void lai_invalidate_bank_cache(void) {
+    lai_current_instance()->bank_generation++;
+}
+
+// Returns true if selections of the bank register can be cached. This requires that the
+// register is a plain Field in a region that LAI accesses itself (writes by host handlers are
+// invisible to us) and that lai_check_bank_write() can track its addresses.
+static int lai_track_bank_register(lai_nsnode_t *bank_node) {
+    struct lai_instance *instance = lai_current_instance();
+    if (bank_node->type != LAI_NAMESPACE_FIELD)
+        return 0;
+
+    lai_nsnode_t *region = bank_node->fld_region_node;
+    void *userptr;
+    if (lai_get_region_ops(region, &userptr))
+        return 0;
+
+    struct lai_bank_register reg = {
+        .space = region->op_address_space,
+        .start = region->op_base + bank_node->fld_offset / 8,
+        .end = region->op_base + (bank_node->fld_offset + bank_node->fld_size + 7) / 8,
+    };
+    for (int i = 0; i < instance->num_bank_registers; i++) {
+        struct lai_bank_register *other = &instance->bank_registers[i];
+        if (other->space == reg.space && other->start <= reg.start && other->end >= reg.end)
+            return 1;
+    }
+    if (instance->num_bank_registers == LAI_BANK_REGISTERS)
+        return 0;
+    instance->bank_registers[instance->num_bank_registers++] = reg;
+    return 1;
+}
+
+// Writes the bank register of a BankField, unless the bank is already selected.
+static void lai_select_bank(lai_nsnode_t *field) {
+    struct lai_instance *instance = lai_current_instance();
+    lai_nsnode_t *bank_node = field->fld_bkf_bank_node;
+
+    int cacheable = lai_track_bank_register(bank_node);
+    if (cacheable && instance->bank_generation
+        && bank_node->fld_bank_generation == instance->bank_generation
+        && bank_node->fld_bank_selected == field->fld_bkf_value)
+        return;
+
     LAI_CLEANUP_VAR lai_variable_t bank = LAI_VAR_INITIALIZER;
     bank.type = LAI_INTEGER;
     bank.integer = field->fld_bkf_value;
 
-    lai_write_field(field->fld_bkf_bank_node, &bank);
+    // This bumps bank_generation, so the selection is recorded afterwards.
+    lai_write_field(bank_node, &bank);
+
+    if (cacheable) {
+        bank_node->fld_bank_selected = field->fld_bkf_value;
+        bank_node->fld_bank_generation = instance->bank_generation;
+    }
+}
+
+void lai_read_bankfield(lai_variable_t *destination, lai_nsnode_t *field) {
+    lai_select_bank(field);
     lai_read_field(destination, field);
 }
 
 void lai_write_bankfield(lai_nsnode_t *field, lai_variable_t *source) {
-    LAI_CLEANUP_VAR lai_variable_t bank = LAI_VAR_INITIALIZER;
-    bank.type = LAI_INTEGER;
-    bank.integer = field->fld_bkf_value;
-
-    lai_write_field(field->fld_bkf_bank_node, &bank);
+    lai_select_bank(field);
     lai_write_field(field, source);
 }
 
@@ -593,3 +756,95 @@ void lai_write_opregion(lai_nsnode_t *field, lai_variable_t *source) {
     else
         lai_panic("undefined field write: %s", lai_stringify_node_path(field));
 }
+
+// Indexed by ACPI_OPREGION_*.
+static const char *lai_address_space_names[] = {"mem",    "io",   "pci",  "ec",  "smbus", "cmos",
+                                                "pcibar", "ipmi", "gpio", "gsb", "pcc"};
+
+const char *lai_stringify_address_space(uint8_t space) {
+    if (space >= sizeof(lai_address_space_names) / sizeof(char *))
+        return NULL;
+    return lai_address_space_names[space];
+}
+
+// Evaluates _REG(space, connect) for a single OperationRegion.
+static void lai_eval_reg(lai_nsnode_t *node, int connect) {
+    // Mark the region first, as _REG may create further regions.
+    node->op_connected = connect;
+
+    // _REG lives in the same scope as the OperationRegion.
+    lai_nsnode_t *parent = lai_ns_get_parent(node);
+    if (!parent)
+        return;
+    lai_nsnode_t *reg_handle = lai_ns_get_child(parent, "_REG");
+    if (!reg_handle)
+        return;
+
+    LAI_CLEANUP_VAR lai_variable_t space_var = LAI_VAR_INITIALIZER;
+    LAI_CLEANUP_VAR lai_variable_t connect_var = LAI_VAR_INITIALIZER;
+    space_var.type = LAI_INTEGER;
+    space_var.integer = node->op_address_space;
+    connect_var.type = LAI_INTEGER;
+    connect_var.integer = connect;
+
+    LAI_CLEANUP_STATE lai_state_t state;
+    lai_init_state(&state);
+    if (lai_eval_largs(NULL, reg_handle, &state, &space_var, &connect_var, NULL)) {
+        LAI_CLEANUP_FREE_STRING char *path = lai_stringify_node_path(reg_handle);
+        lai_warn("could not evaluate %s for address space %02x", path,
+                 node->op_address_space);
+    }
+}
+
+void lai_run_reg_methods(uint8_t space, int connect) {
+    struct lai_instance *instance = lai_current_instance();
+
+    // Deliver Notify() operations from all _REG methods in one batch.
+    lai_exec_enter_eval();
+
+    // _REG may install or uninstall nodes, so neither ns_array nor ns_size can be cached.
+    for (size_t i = 0; i < instance->ns_size; i++) {
+        lai_nsnode_t *node = instance->ns_array[i];
+        if (!node || node->type != LAI_NAMESPACE_OPREGION || node->op_address_space != space
+            || node->op_connected == connect)
+            continue;
+        lai_eval_reg(node, connect);
+    }
+    lai_exec_leave_eval();
+}
+
+void lai_connect_opregion(lai_nsnode_t *node) {
+    LAI_ENSURE(node->type == LAI_NAMESPACE_OPREGION);
+    if (!lai_current_instance()->address_space_handlers[node->op_address_space].ops)
+        return;
+    lai_exec_enter_eval();
+    lai_eval_reg(node, 1);
+    lai_exec_leave_eval();
+}
+
+void lai_connect_opregions(void) {
+    struct lai_instance *instance = lai_current_instance();
+    for (int space = 0; space < 256; space++) {
+        if (instance->address_space_handlers[space].ops)
+            lai_run_reg_methods(space, 1);
+    }
+}
+
+lai_api_error_t lai_install_address_space_handler(uint8_t space,
+                                                  const struct lai_opregion_override *ops,
+                                                  void *userptr) {
+    struct lai_address_space_handler *handler =
+        &lai_current_instance()->address_space_handlers[space];
+
+    // Tell the firmware that the old handler is going away before we replace it.
+    if (handler->ops)
+        lai_run_reg_methods(space, 0);
+
+    handler->ops = ops;
+    handler->userptr = userptr;
+    handler->warned = 0;
+
+    if (ops)
+        lai_run_reg_methods(space, 1);
+    return LAI_ERROR_NONE;
+}
@@ -12,3 +12,18 @@ void lai_write_opregion(lai_nsnode_t *, lai_variable_t *);
 
 void lai_write_field(lai_nsnode_t *, lai_variable_t *);
 void lai_read_field(lai_variable_t *, lai_nsnode_t *);
+
+// Evaluates _REG(space, connect) for all OperationRegions of the given address space that are
+// not already (dis)connected.
+void lai_run_reg_methods(uint8_t space, int connect);
+
+// Evaluates _REG(space, 1) for a new OperationRegion (or for all unconnected regions) if its
+// address space has a handler.
+void lai_connect_opregion(lai_nsnode_t *node);
+void lai_connect_opregions(void);
+
+// Returns a short name of the address space (e.g., "mem" or "io") or NULL if it is unknown.
+const char *lai_stringify_address_space(uint8_t space);
+
+// Forgets which banks of BankFields are currently selected.
+void lai_invalidate_bank_cache(void);
@@ -0,0 +1,128 @@
+/*
+ * Lightweight AML Interpreter
+ * Copyright (C) 2018-2023 The lai authors
+ */
+
+// Internal header file. Do not use outside of LAI.
+
+#pragma once
+
+#include "aml_opcodes.h"
+#include "exec_impl.h"
+
+// Operators, i.e., opcodes that are followed by a fixed list of operands and that are evaluated
+// by lai_exec_reduce_op(). Each entry lists the parse modes of the operands.
+#define LAI_FOREACH_OPERATOR(X)                                                                    \
+    X(STORE_OP, LAI_OBJECT_MODE, LAI_REFERENCE_MODE)                                               \
+    X(COPYOBJECT_OP, LAI_OBJECT_MODE, LAI_REFERENCE_MODE)                                          \
+    X(NOT_OP, LAI_OBJECT_MODE, LAI_REFERENCE_MODE)                                                 \
+    X(FINDSETLEFTBIT_OP, LAI_OBJECT_MODE, LAI_REFERENCE_MODE)                                      \
+    X(FINDSETRIGHTBIT_OP, LAI_OBJECT_MODE, LAI_REFERENCE_MODE)                                     \
+    X(TOBUFFER_OP, LAI_OBJECT_MODE, LAI_REFERENCE_MODE)                                            \
+    X(TODECIMALSTRING_OP, LAI_OBJECT_MODE, LAI_REFERENCE_MODE)                                     \
+    X(TOHEXSTRING_OP, LAI_OBJECT_MODE, LAI_REFERENCE_MODE)                                         \
+    X(TOINTEGER_OP, LAI_OBJECT_MODE, LAI_REFERENCE_MODE)                                           \
+    X((EXTOP_PREFIX << 8) | FROM_BCD_OP, LAI_OBJECT_MODE, LAI_REFERENCE_MODE)                      \
+    X((EXTOP_PREFIX << 8) | TO_BCD_OP, LAI_OBJECT_MODE, LAI_REFERENCE_MODE)                        \
+    X(TOSTRING_OP, LAI_OBJECT_MODE, LAI_OBJECT_MODE, LAI_REFERENCE_MODE)                           \
+    X(CONCAT_OP, LAI_OBJECT_MODE, LAI_OBJECT_MODE, LAI_REFERENCE_MODE)                             \
+    X(CONCATRES_OP, LAI_OBJECT_MODE, LAI_OBJECT_MODE, LAI_REFERENCE_MODE)                          \
+    X(INDEX_OP, LAI_OBJECT_MODE, LAI_OBJECT_MODE, LAI_REFERENCE_MODE)                              \
+    X(ADD_OP, LAI_OBJECT_MODE, LAI_OBJECT_MODE, LAI_REFERENCE_MODE)                                \
+    X(SUBTRACT_OP, LAI_OBJECT_MODE, LAI_OBJECT_MODE, LAI_REFERENCE_MODE)                           \
+    X(MOD_OP, LAI_OBJECT_MODE, LAI_OBJECT_MODE, LAI_REFERENCE_MODE)                                \
+    X(MULTIPLY_OP, LAI_OBJECT_MODE, LAI_OBJECT_MODE, LAI_REFERENCE_MODE)                           \
+    X(AND_OP, LAI_OBJECT_MODE, LAI_OBJECT_MODE, LAI_REFERENCE_MODE)                                \
+    X(OR_OP, LAI_OBJECT_MODE, LAI_OBJECT_MODE, LAI_REFERENCE_MODE)                                 \
+    X(XOR_OP, LAI_OBJECT_MODE, LAI_OBJECT_MODE, LAI_REFERENCE_MODE)                                \
+    X(SHR_OP, LAI_OBJECT_MODE, LAI_OBJECT_MODE, LAI_REFERENCE_MODE)                                \
+    X(SHL_OP, LAI_OBJECT_MODE, LAI_OBJECT_MODE, LAI_REFERENCE_MODE)                                \
+    X(NAND_OP, LAI_OBJECT_MODE, LAI_OBJECT_MODE, LAI_REFERENCE_MODE)                               \
+    X(NOR_OP, LAI_OBJECT_MODE, LAI_OBJECT_MODE, LAI_REFERENCE_MODE)                                \
+    X(MID_OP, LAI_OBJECT_MODE, LAI_OBJECT_MODE, LAI_OBJECT_MODE, LAI_REFERENCE_MODE)               \
+    X(DIVIDE_OP, LAI_OBJECT_MODE, LAI_OBJECT_MODE, LAI_REFERENCE_MODE, LAI_REFERENCE_MODE)         \
+    X(INCREMENT_OP, LAI_REFERENCE_MODE)                                                            \
+    X(DECREMENT_OP, LAI_REFERENCE_MODE)                                                            \
+    X(OBJECTTYPE_OP, LAI_REFERENCE_MODE)                                                           \
+    X(REFOF_OP, LAI_REFERENCE_MODE)                                                                \
+    X((EXTOP_PREFIX << 8) | RELEASE_OP, LAI_REFERENCE_MODE)                                        \
+    X((EXTOP_PREFIX << 8) | SIGNAL_OP, LAI_REFERENCE_MODE)                                         \
+    X((EXTOP_PREFIX << 8) | RESET_OP, LAI_REFERENCE_MODE)                                          \
+    X(LNOT_OP, LAI_OBJECT_MODE)                                                                    \
+    X(DEREF_OP, LAI_OBJECT_MODE)                                                                   \
+    X(SIZEOF_OP, LAI_OBJECT_MODE)                                                                  \
+    X((EXTOP_PREFIX << 8) | STALL_OP, LAI_OBJECT_MODE)                                             \
+    X((EXTOP_PREFIX << 8) | SLEEP_OP, LAI_OBJECT_MODE)                                             \
+    X(LAND_OP, LAI_OBJECT_MODE, LAI_OBJECT_MODE)                                                   \
+    X(LOR_OP, LAI_OBJECT_MODE, LAI_OBJECT_MODE)                                                    \
+    X(LEQUAL_OP, LAI_OBJECT_MODE, LAI_OBJECT_MODE)                                                 \
+    X(LLESS_OP, LAI_OBJECT_MODE, LAI_OBJECT_MODE)                                                  \
+    X(LGREATER_OP, LAI_OBJECT_MODE, LAI_OBJECT_MODE)                                               \
+    X(NOTIFY_OP, LAI_REFERENCE_MODE, LAI_OBJECT_MODE)                                              \
+    X((EXTOP_PREFIX << 8) | WAIT_OP, LAI_REFERENCE_MODE, LAI_OBJECT_MODE)                          \
+    X((EXTOP_PREFIX << 8) | ACQUIRE_OP, LAI_REFERENCE_MODE, LAI_IMMEDIATE_WORD_MODE)               \
+    X((EXTOP_PREFIX << 8) | CONDREF_OP, LAI_OPTIONAL_REFERENCE_MODE, LAI_REFERENCE_MODE)           \
+    X(MATCH_OP, LAI_OBJECT_MODE, LAI_IMMEDIATE_BYTE_MODE, LAI_OBJECT_MODE,                         \
+      LAI_IMMEDIATE_BYTE_MODE, LAI_OBJECT_MODE, LAI_OBJECT_MODE)                                   \
+    X((EXTOP_PREFIX << 8) | FATAL_OP, LAI_IMMEDIATE_BYTE_MODE, LAI_IMMEDIATE_DWORD_MODE,           \
+      LAI_OBJECT_MODE)
+
+// Opcodes are mapped to [0, 256) and extended opcodes to [256, 512).
+#define LAI_OP_INDEX(opcode) (((opcode) >> 8) ? 256 + ((opcode)&0xFF) : (opcode))
+
+struct lai_op_desc {
+    // Parse modes of the operands, terminated by zero. Matches lai_stackitem_t::op_arg_modes.
+    uint8_t arg_modes[8];
+};
+
+extern const struct lai_op_desc lai_op_descs[512];
+
+// Returns NULL if the opcode is not an operator.
+static inline const struct lai_op_desc *lai_op_desc(int opcode) {
+    const struct lai_op_desc *desc = &lai_op_descs[LAI_OP_INDEX(opcode)];
+    if (!desc->arg_modes[0])
+        return NULL;
+    return desc;
+}
+
+// Evaluates an arithmetic, logical or comparison operator on integers. Unary operators ignore
+// rhs. Used by the integer fast paths; lai_exec_reduce_op() is the reference implementation.
+static inline uint64_t lai_op_eval_integer(int opcode, uint64_t lhs, uint64_t rhs) {
+    switch (opcode) {
+        case ADD_OP:
+            return lhs + rhs;
+        case SUBTRACT_OP:
+            return lhs - rhs;
+        case MULTIPLY_OP:
+            return lhs * rhs;
+        case AND_OP:
+            return lhs & rhs;
+        case OR_OP:
+            return lhs | rhs;
+        case XOR_OP:
+            return lhs ^ rhs;
+        case NAND_OP:
+            return ~(lhs & rhs);
+        case NOR_OP:
+            return ~(lhs | rhs);
+        case SHL_OP:
+            return lhs << rhs;
+        case SHR_OP:
+            return lhs >> rhs;
+        case NOT_OP:
+            return ~lhs;
+        case LNOT_OP:
+            return !lhs;
+        case LAND_OP:
+            return lhs && rhs;
+        case LOR_OP:
+            return lhs || rhs;
+        case LEQUAL_OP:
+            return (lhs == rhs) ? ~((uint64_t)0) : 0;
+        case LLESS_OP:
+            return (lhs < rhs) ? ~((uint64_t)0) : 0;
+        default:
+            LAI_ENSURE(opcode == LGREATER_OP);
+            return (lhs > rhs) ? ~((uint64_t)0) : 0;
+    }
+}
@@ -29,7 +29,7 @@ static const char *supported_osi_strings[] = {
 
 // Pretend to be windows when we execute the OSI() method.
 int lai_do_osi_method(lai_variable_t *args, lai_variable_t *result) {
-    const char *query = lai_exec_string_access(&args[0]);
+    const char *query = lai_exec_string_view(&args[0]);
 
     uint32_t osi_return = 0;
     for (size_t i = 0; i < LAI_SIZEOF_ARRAY(supported_osi_strings); i++) {
@@ -0,0 +1,160 @@
+/*
+ * Lightweight AML Interpreter
+ * Copyright (C) 2018-2023 The lai authors
+ */
+
+#include <lai/core.h>
+
+#include "libc.h"
+#include "opregion.h"
+#include "profile.h"
+
+#ifdef LAI_PROFILE
+
+static uint64_t lai_profile_timer(void) {
+    if (!laihost_timer)
+        return 0;
+    return laihost_timer();
+}
+
+void lai_profile_enter(struct lai_invocation *invocation, lai_nsnode_t *method) {
+    struct lai_instance *instance = lai_current_instance();
+    if (!instance->profile_enabled)
+        return;
+
+    struct lai_profile *profile = method->mth_profile;
+    if (!profile) {
+        profile = laihost_malloc(sizeof(struct lai_profile));
+        if (!profile)
+            return;
+        memset(profile, 0, sizeof(struct lai_profile));
+        method->mth_profile = profile;
+    }
+    profile->invocations++;
+
+    invocation->prof_record = profile;
+    invocation->prof_caller = instance->profile_invocation;
+    invocation->prof_start = lai_profile_timer();
+    instance->profile_invocation = invocation;
+    instance->profile_current = profile;
+}
+
+void lai_profile_leave(struct lai_invocation *invocation) {
+    struct lai_instance *instance = lai_current_instance();
+    struct lai_profile *profile = invocation->prof_record;
+    if (!profile)
+        return;
+
+    uint64_t elapsed = lai_profile_timer() - invocation->prof_start;
+    profile->inclusive_time += elapsed;
+    profile->exclusive_time += elapsed - invocation->prof_callee_time;
+
+    struct lai_invocation *caller = invocation->prof_caller;
+    if (caller)
+        caller->prof_callee_time += elapsed;
+    instance->profile_invocation = caller;
+    instance->profile_current =
+        (instance->profile_enabled && caller) ? caller->prof_record : NULL;
+}
+
+#endif // LAI_PROFILE
+
+void lai_enable_profiling(int enable) {
+    struct lai_instance *instance = lai_current_instance();
+#ifndef LAI_PROFILE
+    if (enable) {
+        lai_warn("profiling is not available, LAI was built without LAI_PROFILE");
+        return;
+    }
+#endif
+    instance->profile_enabled = enable;
+    if (enable && instance->profile_invocation)
+        instance->profile_current = instance->profile_invocation->prof_record;
+    else
+        instance->profile_current = NULL;
+}
+
+struct lai_profile *lai_get_profile(lai_nsnode_t *method) {
+    if (method->type != LAI_NAMESPACE_METHOD)
+        return NULL;
+    return method->mth_profile;
+}
+
+void lai_profile_reset(void) {
+    struct lai_instance *instance = lai_current_instance();
+    for (size_t i = 0; i < instance->ns_size; i++) {
+        lai_nsnode_t *node = instance->ns_array[i];
+        if (!node || node->type != LAI_NAMESPACE_METHOD || !node->mth_profile)
+            continue;
+        memset(node->mth_profile, 0, sizeof(struct lai_profile));
+    }
+}
+
+// Returns true if a should be reported before b.
+static int lai_profile_before(struct lai_profile *a, struct lai_profile *b) {
+    if (a->exclusive_time != b->exclusive_time)
+        return a->exclusive_time > b->exclusive_time;
+    return a->opcodes > b->opcodes;
+}
+
+void lai_profile_dump(size_t n) {
+    struct lai_instance *instance = lai_current_instance();
+    if (!n)
+        return;
+    lai_nsnode_t **top = laihost_malloc(n * sizeof(lai_nsnode_t *));
+    if (!top) {
+        lai_warn("could not allocate memory for lai_profile_dump()");
+        return;
+    }
+
+    // Insertion sort into the (sorted) array of the top n methods.
+    size_t num_profiled = 0;
+    size_t num_top = 0;
+    for (size_t i = 0; i < instance->ns_size; i++) {
+        lai_nsnode_t *node = instance->ns_array[i];
+        if (!node || node->type != LAI_NAMESPACE_METHOD || !node->mth_profile
+            || !node->mth_profile->invocations)
+            continue;
+        num_profiled++;
+
+        size_t k = num_top;
+        while (k && lai_profile_before(node->mth_profile, top[k - 1]->mth_profile)) {
+            if (k < n)
+                top[k] = top[k - 1];
+            k--;
+        }
+        if (k < n)
+            top[k] = node;
+        if (num_top < n)
+            num_top++;
+    }
+
+    lai_debug("profile of %lu methods:", num_profiled);
+    for (size_t k = 0; k < num_top; k++) {
+        struct lai_profile *profile = top[k]->mth_profile;
+        LAI_CLEANUP_FREE_STRING char *path = lai_stringify_node_path(top[k]);
+        lai_debug("%s: %lu calls, time %lu/%lu (excl/incl), %lu opcodes, %lu allocs", path,
+                  profile->invocations, profile->exclusive_time, profile->inclusive_time,
+                  profile->opcodes, profile->allocations);
+
+        char accesses[96] = "";
+        size_t length = 0;
+        for (int space = 0; space < LAI_PROFILE_SPACES; space++) {
+            if (!profile->region_accesses[space])
+                continue;
+            const char *name = lai_stringify_address_space(space);
+            if (space == LAI_PROFILE_SPACES - 1)
+                name = "other";
+            if (name)
+                lai_snprintf(accesses + length, sizeof(accesses) - length, " %s=%lu", name,
+                             profile->region_accesses[space]);
+            else
+                lai_snprintf(accesses + length, sizeof(accesses) - length, " 0x%02X=%lu", space,
+                             profile->region_accesses[space]);
+            length = lai_strlen(accesses);
+        }
+        if (length)
+            lai_debug("%s: region accesses%s", path, accesses);
+    }
+    laihost_free(top, n * sizeof(lai_nsnode_t *));
+}
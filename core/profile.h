@@ -0,0 +1,65 @@
+/*
+ * Lightweight AML Interpreter
+ * Copyright (C) 2018-2023 The lai authors
+ */
+
+// Internal header file. Do not use outside of LAI.
+
+#pragma once
+
+#include <lai/core.h>
+
+#include "libc.h"
+
+// Hooks of the per-method profiler, see lai_enable_profiling().
+//
+// Unless LAI is built with LAI_PROFILE, the hooks are empty. Otherwise, statistics are
+// attributed to lai_current_instance()->profile_current, which is NULL if profiling is disabled
+// (or if no method is running). Thus, disabled profiling costs one load and one branch per hook.
+
+#ifdef LAI_PROFILE
+
+// Called once the invocation of an AML method is set up and before it is torn down.
+void lai_profile_enter(struct lai_invocation *invocation, lai_nsnode_t *method);
+void lai_profile_leave(struct lai_invocation *invocation);
+
+static inline void lai_profile_opcode(void) {
+    struct lai_profile *profile = lai_current_instance()->profile_current;
+    if (profile)
+        profile->opcodes++;
+}
+
+static inline void lai_profile_region_access(uint8_t space) {
+    struct lai_profile *profile = lai_current_instance()->profile_current;
+    if (profile)
+        profile->region_accesses[LAI_MIN(space, LAI_PROFILE_SPACES - 1)]++;
+}
+
+static inline void lai_profile_alloc(void) {
+    struct lai_profile *profile = lai_current_instance()->profile_current;
+    if (profile)
+        profile->allocations++;
+}
+
+#else // LAI_PROFILE
+
+static inline void lai_profile_enter(struct lai_invocation *invocation, lai_nsnode_t *method) {
+    (void)invocation;
+    (void)method;
+}
+
+static inline void lai_profile_leave(struct lai_invocation *invocation) {
+    (void)invocation;
+}
+
+static inline void lai_profile_opcode(void) {
+}
+
+static inline void lai_profile_region_access(uint8_t space) {
+    (void)space;
+}
+
+static inline void lai_profile_alloc(void) {
+}
+
+#endif // LAI_PROFILE
@@ -0,0 +1,135 @@
+/*
+ * Lightweight AML Interpreter
+ * Copyright (C) 2018-2023 The lai authors
+ */
+
+#include <lai/core.h>
+
+#include "libc.h"
+#include "opregion.h"
+#include "trace.h"
+
+int lai_trace_emit(int event, int opcode, size_t offset, lai_nsnode_t *node, uint64_t value) {
+    struct lai_trace_ring *ring = lai_current_instance()->trace_ring;
+    if (!ring)
+        return 0;
+
+    // Only LAI writes to head.
+    size_t head = ring->head;
+    if (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) == ring->size) {
+        __atomic_fetch_add(&ring->dropped, 1, __ATOMIC_RELAXED);
+        return 1;
+    }
+
+    struct lai_trace_record *record = &ring->records[head & (ring->size - 1)];
+    record->timestamp = laihost_timer ? laihost_timer() : 0;
+    record->value = value;
+    record->node = (uintptr_t)node;
+    record->offset = offset;
+    record->opcode = opcode;
+    record->event = event;
+    record->reserved = 0;
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+void lai_enable_trace_ring(struct lai_trace_ring *ring) {
+    if (ring)
+        LAI_ENSURE(ring->size && !(ring->size & (ring->size - 1)));
+    lai_current_instance()->trace_ring = ring;
+}
+
+size_t lai_trace_ring_consume(struct lai_trace_ring *ring, struct lai_trace_record *records,
+                              size_t n) {
+    // Only the consumer writes to tail.
+    size_t tail = ring->tail;
+    size_t available = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - tail;
+    n = LAI_MIN(n, available);
+    for (size_t i = 0; i < n; i++)
+        records[i] = ring->records[(tail + i) & (ring->size - 1)];
+    __atomic_store_n(&ring->tail, tail + n, __ATOMIC_RELEASE);
+    return n;
+}
+
+// Returns NULL unless the node is (still) part of the namespace.
+static lai_nsnode_t *lai_trace_lookup_node(uint64_t address) {
+    struct lai_instance *instance = lai_current_instance();
+    if (!address)
+        return NULL;
+    for (size_t i = 0; i < instance->ns_size; i++) {
+        if ((uintptr_t)instance->ns_array[i] == address)
+            return instance->ns_array[i];
+    }
+    return NULL;
+}
+
+void lai_trace_format(const struct lai_trace_record *record, char *buffer, size_t size) {
+    lai_nsnode_t *node = lai_trace_lookup_node(record->node);
+    LAI_CLEANUP_FREE_STRING char *path = NULL;
+    if (node)
+        path = lai_stringify_node_path(node);
+
+    char symbol[32] = "-";
+    if (record->node && !node)
+        lai_snprintf(symbol, sizeof(symbol), "%lx", (size_t)record->node);
+    const char *name = path ? path : symbol;
+
+    // Prefix with the timestamp; the rest depends on the event.
+    lai_snprintf(buffer, size, "%lu: ", record->timestamp);
+    size_t n = lai_strlen(buffer);
+    buffer += n;
+    size -= n;
+
+    switch (record->event) {
+        case LAI_TRACE_EVENT_OPCODE:
+            lai_snprintf(buffer, size, "opcode 0x%02X [0x%x] in %s", record->opcode,
+                         record->offset, name);
+            break;
+        case LAI_TRACE_EVENT_NAME:
+            lai_snprintf(buffer, size, "name %s [0x%x]", name, record->offset);
+            break;
+        case LAI_TRACE_EVENT_INVOKE:
+            lai_snprintf(buffer, size, "invocation %s [0x%x]", name, record->offset);
+            break;
+        case LAI_TRACE_EVENT_REDUCE:
+            lai_snprintf(buffer, size, "reduce 0x%02X", record->opcode);
+            break;
+        case LAI_TRACE_EVENT_IO_READ:
+        case LAI_TRACE_EVENT_IO_WRITE: {
+            const char *space = node ? lai_stringify_address_space(node->op_address_space) : NULL;
+            lai_snprintf(buffer, size, "%u-bit %s %lx %s %s+0x%x (%s)", record->opcode,
+                         (record->event == LAI_TRACE_EVENT_IO_READ) ? "read" : "write",
+                         (size_t)record->value,
+                         (record->event == LAI_TRACE_EVENT_IO_READ) ? "from" : "to", name,
+                         record->offset, space ? space : "?");
+            break;
+        }
+        case LAI_TRACE_EVENT_IO_BULK_READ:
+        case LAI_TRACE_EVENT_IO_BULK_WRITE:
+            lai_snprintf(buffer, size, "%lu-byte bulk %s %s+0x%x", (size_t)record->value,
+                         (record->event == LAI_TRACE_EVENT_IO_BULK_READ) ? "read from"
+                                                                         : "write to",
+                         name, record->offset);
+            break;
+        case LAI_TRACE_EVENT_NS_INSTALL:
+            lai_snprintf(buffer, size, "install %s (type %u)", name, record->opcode);
+            break;
+        default:
+            lai_snprintf(buffer, size, "unknown event %u", record->event);
+    }
+}
+
+void lai_trace_dump(struct lai_trace_ring *ring) {
+    size_t dropped = __atomic_exchange_n(&ring->dropped, 0, __ATOMIC_RELAXED);
+    if (dropped)
+        lai_warn("trace ring dropped %lu records", dropped);
+
+    struct lai_trace_record record;
+    while (lai_trace_ring_consume(ring, &record, 1)) {
+        // Unlike lai_debug(), do not truncate long paths.
+        char buffer[256];
+        lai_trace_format(&record, buffer, sizeof(buffer));
+        if (laihost_log)
+            laihost_log(LAI_DEBUG_LOG, buffer);
+    }
+}
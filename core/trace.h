@@ -0,0 +1,14 @@
+/*
+ * Lightweight AML Interpreter
+ * Copyright (C) 2018-2023 The lai authors
+ */
+
+// Internal header file. Do not use outside of LAI.
+
+#pragma once
+
+#include <lai/core.h>
+
+// Appends a record to the ring that was installed by lai_enable_trace_ring(). Returns false if
+// there is no ring; callers then log the event through lai_debug() instead.
+int lai_trace_emit(int event, int opcode, size_t offset, lai_nsnode_t *node, uint64_t value);
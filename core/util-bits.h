@@ -0,0 +1,77 @@
+/*
+ * Lightweight AML Interpreter
+ * Copyright (C) 2018-2023 The lai authors
+ */
+
+// Internal header file. Do not use outside of LAI.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Bit strings as used by buffer fields and field units: bit i is bit (i & 7) of byte (i / 8).
+// Like the rest of LAI, these functions assume a little endian host.
+
+// Loads up to 8 bytes. Bytes at or beyond data + size read as zero.
+static inline uint64_t lai_bits_load_word(const uint8_t *data, size_t size, size_t index) {
+    uint64_t word = 0;
+    if (index + 8 <= size) {
+        __builtin_memcpy(&word, data + index, 8);
+    } else {
+        for (size_t i = 0; index + i < size && i < 8; i++)
+            word |= (uint64_t)data[index + i] << (i * 8);
+    }
+    return word;
+}
+
+// Returns num_bits (at most 64) bits starting at bit_offset.
+static inline uint64_t lai_bits_get(const uint8_t *data, size_t size, size_t bit_offset,
+                                    size_t num_bits) {
+    size_t index = bit_offset / 8;
+    unsigned int shift = bit_offset & 7;
+
+    uint64_t value = lai_bits_load_word(data, size, index) >> shift;
+    // A field of up to 64 bits can span a ninth byte if it does not start at a byte boundary.
+    if (shift + num_bits > 64 && index + 8 < size)
+        value |= (uint64_t)data[index + 8] << (64 - shift);
+
+    if (num_bits < 64)
+        value &= (UINT64_C(1) << num_bits) - 1;
+    return value;
+}
+
+// Replaces num_bits (at most 64) bits starting at bit_offset. All other bits are preserved.
+// The bits must be within the first size bytes of data.
+static inline void lai_bits_put(uint8_t *data, size_t size, size_t bit_offset, size_t num_bits,
+                                uint64_t value) {
+    size_t index = bit_offset / 8;
+    unsigned int shift = bit_offset & 7;
+
+    uint64_t mask = ~UINT64_C(0);
+    if (num_bits < 64)
+        mask = (UINT64_C(1) << num_bits) - 1;
+    value &= mask;
+
+    if (index + 8 <= size) {
+        uint64_t word;
+        __builtin_memcpy(&word, data + index, 8);
+        word = (word & ~(mask << shift)) | (value << shift);
+        __builtin_memcpy(data + index, &word, 8);
+    } else if (!shift && !(num_bits & 7)) {
+        // Whole bytes at the end of the data can just be copied.
+        __builtin_memcpy(data + index, &value, num_bits / 8);
+        return;
+    } else {
+        for (size_t i = 0; index + i < size && i < 8; i++) {
+            uint8_t byte_mask = (mask << shift) >> (i * 8);
+            uint8_t byte_value = (value << shift) >> (i * 8);
+            data[index + i] = (data[index + i] & ~byte_mask) | byte_value;
+        }
+    }
+
+    if (shift + num_bits > 64) {
+        uint8_t high_mask = mask >> (64 - shift);
+        data[index + 8] = (data[index + 8] & ~high_mask) | (uint8_t)(value >> (64 - shift));
+    }
+}
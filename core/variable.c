@@ -8,12 +8,18 @@
 #include "exec_impl.h"
 #include "libc.h"
 
-// laihost_free_package(): Frees a package object and all its children
-static void laihost_free_package(lai_variable_t *object) {
-    for (size_t i = 0; i < object->pkg_ptr->size; i++)
-        lai_var_finalize(&object->pkg_ptr->elems[i]);
-    laihost_free(object->pkg_ptr->elems, object->pkg_ptr->size * sizeof(lai_variable_t));
-    laihost_free(object->pkg_ptr, sizeof(struct lai_pkg_head));
+void lai_release_storage(struct lai_storage *storage) {
+    if (lai_rc_unref(&storage->rc))
+        laihost_free(storage, sizeof(struct lai_storage) + storage->size);
+}
+
+void lai_release_pkg_storage(struct lai_storage *storage) {
+    if (lai_rc_unref(&storage->rc)) {
+        lai_variable_t *elems = lai_storage_data(storage);
+        for (size_t i = 0; i < storage->size / sizeof(lai_variable_t); i++)
+            lai_var_finalize(&elems[i]);
+        laihost_free(storage, sizeof(struct lai_storage) + storage->size);
+    }
 }
 
 void lai_var_finalize(lai_variable_t *object) {
@@ -21,21 +27,30 @@ void lai_var_finalize(lai_variable_t *object) {
         case LAI_STRING:
         case LAI_STRING_INDEX:
             if (lai_rc_unref(&object->string_ptr->rc)) {
-                laihost_free(object->string_ptr->content, object->string_ptr->capacity);
-                laihost_free(object->string_ptr, sizeof(struct lai_string_head));
+                if (object->string_ptr->storage)
+                    lai_release_storage(object->string_ptr->storage);
+                laihost_free(object->string_ptr,
+                             sizeof(struct lai_string_head) + object->string_ptr->inline_size);
             }
             break;
         case LAI_BUFFER:
         case LAI_BUFFER_INDEX:
             if (lai_rc_unref(&object->buffer_ptr->rc)) {
-                laihost_free(object->buffer_ptr->content, object->buffer_ptr->size);
-                laihost_free(object->buffer_ptr, sizeof(struct lai_buffer_head));
+                if (object->buffer_ptr->storage)
+                    lai_release_storage(object->buffer_ptr->storage);
+                laihost_free(object->buffer_ptr,
+                             sizeof(struct lai_buffer_head) + object->buffer_ptr->inline_size);
             }
             break;
         case LAI_PACKAGE:
         case LAI_PACKAGE_INDEX:
-            if (lai_rc_unref(&object->pkg_ptr->rc))
-                laihost_free_package(object);
+            if (lai_rc_unref(&object->pkg_ptr->rc)) {
+                if (object->pkg_ptr->packed)
+                    lai_release_storage(object->pkg_ptr->storage);
+                else
+                    lai_release_pkg_storage(object->pkg_ptr->storage);
+                laihost_free(object->pkg_ptr, sizeof(struct lai_pkg_head));
+            }
             break;
     }
 
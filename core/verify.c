@@ -0,0 +1,617 @@
+/*
+ * Lightweight AML Interpreter
+ * Copyright (C) 2018-2023 The lai authors
+ */
+
+#include <lai/core.h>
+
+#include "aml_opcodes.h"
+#include "eval.h"
+#include "exec_impl.h"
+#include "libc.h"
+#include "opregion.h"
+#include "ops.h"
+#include "verify.h"
+
+// Bounds the recursion of lai_verify_term(). Deeper methods are left unverified.
+#define LAI_VERIFY_MAX_DEPTH 64
+
+struct lai_verifier {
+    lai_nsnode_t *method;
+    uint8_t *code;
+    int depth;
+    int impure; // Set if the code has side effects, see lai_method_is_pure().
+    struct lai_method_info *info;
+
+    // State for the detection of unbounded loops.
+    int block_depth;
+    int reads_variables; // Set if LocalX, ArgX or Name() objects are read.
+    int breaks; // Set if the innermost While() contains a Break.
+    int returns; // Number of Return statements.
+};
+
+static int lai_verify_term(struct lai_verifier *v, int *pc, int limit, int mode);
+
+static int lai_verify_name_char(uint8_t c, int lead) {
+    if ((c >= 'A' && c <= 'Z') || c == '_')
+        return 1;
+    return !lead && c >= '0' && c <= '9';
+}
+
+// Checks a NameString. On success, *pc is advanced past the name.
+static int lai_verify_name(struct lai_verifier *v, int *pc, int limit) {
+    uint8_t *code = v->code;
+    if (*pc < limit && code[*pc] == ROOT_CHAR) {
+        (*pc)++;
+    } else {
+        while (*pc < limit && code[*pc] == PARENT_CHAR)
+            (*pc)++;
+    }
+    if (*pc >= limit)
+        return 1;
+
+    size_t num_segs;
+    if (!code[*pc]) {
+        (*pc)++;
+        return 0;
+    } else if (code[*pc] == DUAL_PREFIX) {
+        (*pc)++;
+        num_segs = 2;
+    } else if (code[*pc] == MULTI_PREFIX) {
+        if (*pc + 1 >= limit || code[*pc + 1] <= 2)
+            return 1;
+        num_segs = code[*pc + 1];
+        *pc += 2;
+    } else {
+        num_segs = 1;
+    }
+
+    if (num_segs * 4 > (size_t)(limit - *pc))
+        return 1;
+    for (size_t i = 0; i < num_segs * 4; i++) {
+        if (!lai_verify_name_char(code[*pc + i], !(i & 3)))
+            return 1;
+    }
+    *pc += num_segs * 4;
+    return 0;
+}
+
+// Checks a PkgLength and returns the end of the package in *end.
+static int lai_verify_pkglength(struct lai_verifier *v, int opcode_pc, int *pc, int limit,
+                                int *end) {
+    size_t size;
+    if (lai_parse_varint(&size, v->code, pc, limit))
+        return 1;
+    if (size > (size_t)(limit - opcode_pc - 1))
+        return 1;
+    *end = opcode_pc + 1 + size;
+    return *pc > *end;
+}
+
+// Checks a sequence of terms that ends exactly at limit.
+static int lai_verify_terms(struct lai_verifier *v, int pc, int limit, int mode) {
+    while (pc < limit) {
+        if (lai_verify_term(v, &pc, limit, mode))
+            return 1;
+    }
+    return 0;
+}
+
+// Checks the body of an If(), Else() or While().
+static int lai_verify_block(struct lai_verifier *v, int pc, int limit) {
+    v->block_depth++;
+    if (v->info->max_block_depth < v->block_depth)
+        v->info->max_block_depth = v->block_depth;
+    int failed = lai_verify_terms(v, pc, limit, LAI_EXEC_MODE);
+    v->block_depth--;
+    return failed;
+}
+
+static void lai_verify_add_space(struct lai_verifier *v, uint8_t space) {
+    v->info->flags |= LAI_METHOD_ACCESSES_REGIONS;
+    v->info->region_spaces[space >> 5] |= (uint32_t)1 << (space & 31);
+}
+
+// Records the address spaces that are accessed through a field.
+static void lai_verify_add_field(struct lai_verifier *v, lai_nsnode_t *node) {
+    switch (node->type) {
+        case LAI_NAMESPACE_FIELD:
+            lai_verify_add_space(v, node->fld_region_node->op_address_space);
+            break;
+        case LAI_NAMESPACE_BANKFIELD:
+            lai_verify_add_space(v, node->fld_region_node->op_address_space);
+            lai_verify_add_field(v, node->fld_bkf_bank_node);
+            break;
+        case LAI_NAMESPACE_INDEXFIELD:
+            lai_verify_add_field(v, node->fld_idxf_index_node);
+            lai_verify_add_field(v, node->fld_idxf_data_node);
+            break;
+    }
+}
+
+// Checks the name of a region or field that a Field() (or friends) is defined on
+// and records its address space.
+static int lai_verify_field_source(struct lai_verifier *v, int *pc, int limit) {
+    struct lai_amlname amln;
+    int name_pc = *pc;
+    if (lai_verify_name(v, pc, limit))
+        return 1;
+    lai_amlname_parse(&amln, v->code + name_pc);
+    lai_nsnode_t *node = lai_do_resolve(v->method, &amln);
+    if (!node)
+        return 0;
+    if (node->type == LAI_NAMESPACE_OPREGION)
+        lai_verify_add_space(v, node->op_address_space);
+    else
+        lai_verify_add_field(v, node);
+    return 0;
+}
+
+// Returns true if the opcode (that ends before pc) has effects other than computing a value
+// or storing to LocalX.
+static int lai_verify_has_side_effects(struct lai_verifier *v, int opcode, int pc, int limit,
+                                       int mode) {
+    // Only LocalX and the null target can be stored to. Stores to ArgX may go through
+    // references; Index() and friends may refer to named objects.
+    if (!(lai_mode_flags[mode] & LAI_MF_INVOKE) && mode != LAI_DATA_MODE)
+        return opcode != ZERO_OP && !(opcode >= LOCAL0_OP && opcode <= LOCAL7_OP);
+
+    switch (opcode) {
+        case NOTIFY_OP:
+        case REFOF_OP:
+        case (EXTOP_PREFIX << 8) | CONDREF_OP:
+        case (EXTOP_PREFIX << 8) | TIMER_OP:
+        case (EXTOP_PREFIX << 8) | DEBUG_OP:
+        case (EXTOP_PREFIX << 8) | STALL_OP:
+        case (EXTOP_PREFIX << 8) | SLEEP_OP:
+        case (EXTOP_PREFIX << 8) | ACQUIRE_OP:
+        case (EXTOP_PREFIX << 8) | RELEASE_OP:
+        case (EXTOP_PREFIX << 8) | WAIT_OP:
+        case (EXTOP_PREFIX << 8) | SIGNAL_OP:
+        case (EXTOP_PREFIX << 8) | RESET_OP:
+        case (EXTOP_PREFIX << 8) | FATAL_OP:
+            return 1;
+        case DEREF_OP:
+            // Unlike elements of Index(), references may point to fields.
+            return pc >= limit || v->code[pc] != INDEX_OP;
+        default:
+            return 0;
+    }
+}
+
+static int lai_verify_opcode(struct lai_verifier *v, int *pc, int limit, int mode) {
+    uint8_t *code = v->code;
+    int opcode_pc = *pc;
+    int opcode;
+    if (code[*pc] == EXTOP_PREFIX) {
+        if (*pc + 1 >= limit)
+            return 1;
+        opcode = (EXTOP_PREFIX << 8) | code[*pc + 1];
+        *pc += 2;
+    } else {
+        opcode = code[*pc];
+        (*pc)++;
+    }
+
+    if (lai_verify_has_side_effects(v, opcode, *pc, limit, mode))
+        v->impure = 1;
+    switch (opcode) {
+        case (EXTOP_PREFIX << 8) | STALL_OP:
+        case (EXTOP_PREFIX << 8) | SLEEP_OP:
+            v->info->flags |= LAI_METHOD_SLEEPS;
+            break;
+        case (EXTOP_PREFIX << 8) | ACQUIRE_OP:
+        case (EXTOP_PREFIX << 8) | WAIT_OP:
+            v->info->flags |= LAI_METHOD_WAITS;
+            break;
+    }
+
+    const struct lai_op_desc *desc = lai_op_desc(opcode);
+    if (desc) {
+        for (int i = 0; desc->arg_modes[i]; i++) {
+            if (lai_verify_term(v, pc, limit, desc->arg_modes[i]))
+                return 1;
+        }
+        return 0;
+    }
+
+    if ((opcode >= LOCAL0_OP && opcode <= LOCAL7_OP)
+        || (opcode >= ARG0_OP && opcode <= ARG6_OP)) {
+        v->reads_variables = 1;
+        return 0;
+    }
+
+    int end;
+    switch (opcode) {
+        case ZERO_OP:
+        case ONE_OP:
+        case ONES_OP:
+        case (EXTOP_PREFIX << 8) | REVISION_OP:
+        case (EXTOP_PREFIX << 8) | TIMER_OP:
+        case (EXTOP_PREFIX << 8) | DEBUG_OP:
+            return 0;
+        case BYTEPREFIX:
+            return lai_verify_term(v, pc, limit, LAI_IMMEDIATE_BYTE_MODE);
+        case WORDPREFIX:
+            return lai_verify_term(v, pc, limit, LAI_IMMEDIATE_WORD_MODE);
+        case DWORDPREFIX:
+            return lai_verify_term(v, pc, limit, LAI_IMMEDIATE_DWORD_MODE);
+        case QWORDPREFIX:
+            if (limit - *pc < 8)
+                return 1;
+            *pc += 8;
+            return 0;
+        case STRINGPREFIX:
+            while (*pc < limit && code[*pc])
+                (*pc)++;
+            if (*pc == limit)
+                return 1;
+            (*pc)++;
+            return 0;
+        case BUFFER_OP:
+            // The initializer is raw data.
+            if (lai_verify_pkglength(v, opcode_pc, pc, limit, &end)
+                || lai_verify_term(v, pc, end, LAI_OBJECT_MODE))
+                return 1;
+            *pc = end;
+            return 0;
+        case PACKAGE_OP:
+        case VARPACKAGE_OP:
+            if (lai_verify_pkglength(v, opcode_pc, pc, limit, &end)
+                || lai_verify_term(v, pc, end,
+                                   (opcode == PACKAGE_OP) ? LAI_IMMEDIATE_BYTE_MODE
+                                                          : LAI_OBJECT_MODE)
+                || lai_verify_terms(v, *pc, end, LAI_DATA_MODE))
+                return 1;
+            *pc = end;
+            return 0;
+    }
+
+    // Everything else is only valid as a statement.
+    if (mode != LAI_EXEC_MODE)
+        return 1;
+    switch (opcode) {
+        case NOP_OP:
+        case BREAKPOINT_OP:
+        case CONTINUE_OP:
+            return 0;
+        case BREAK_OP:
+            v->breaks = 1;
+            return 0;
+        case RETURN_OP:
+            v->returns++;
+            return lai_verify_term(v, pc, limit, LAI_OBJECT_MODE);
+        case WHILE_OP: {
+            // Loops are considered unbounded if their predicate does not depend on variables
+            // (e.g., While (One) or loops that poll fields) and if they are not left through
+            // Break or Return.
+            int reads_variables = v->reads_variables;
+            int breaks = v->breaks;
+            int returns = v->returns;
+            v->reads_variables = 0;
+            v->breaks = 0;
+            if (lai_verify_pkglength(v, opcode_pc, pc, limit, &end)
+                || lai_verify_term(v, pc, end, LAI_OBJECT_MODE))
+                return 1;
+            int bounded = v->reads_variables;
+            if (lai_verify_block(v, *pc, end))
+                return 1;
+            if (!bounded && !v->breaks && v->returns == returns)
+                v->info->flags |= LAI_METHOD_UNBOUNDED_LOOP;
+            v->reads_variables |= reads_variables;
+            v->breaks = breaks;
+            *pc = end;
+            return 0;
+        }
+        case IF_OP:
+            if (lai_verify_pkglength(v, opcode_pc, pc, limit, &end)
+                || lai_verify_term(v, pc, end, LAI_OBJECT_MODE)
+                || lai_verify_block(v, *pc, end))
+                return 1;
+            *pc = end;
+            if (*pc < limit && code[*pc] == ELSE_OP) {
+                int else_pc = (*pc)++;
+                if (lai_verify_pkglength(v, else_pc, pc, limit, &end)
+                    || lai_verify_block(v, *pc, end))
+                    return 1;
+                *pc = end;
+            }
+            return 0;
+        case EXTERNAL_OP:
+            if (lai_verify_name(v, pc, limit) || limit - *pc < 2)
+                return 1;
+            *pc += 2;
+            return 0;
+    }
+
+    // Opcodes that create namespace nodes are decoded for lai_analyze_method() only.
+    // Whether they succeed (and hence, how names in the remaining code resolve) is only
+    // known at run time; thus, such methods are never verified.
+    int ext_pc = opcode_pc + 1; // PkgLengths of extended opcodes start after the prefix.
+    switch (opcode) {
+        case NAME_OP:
+            if (lai_verify_term(v, pc, limit, LAI_UNRESOLVED_MODE)
+                || lai_verify_term(v, pc, limit, LAI_OBJECT_MODE))
+                return 1;
+            break;
+        case ALIAS_OP:
+            if (lai_verify_name(v, pc, limit) || lai_verify_name(v, pc, limit))
+                return 1;
+            break;
+        case BITFIELD_OP:
+        case BYTEFIELD_OP:
+        case WORDFIELD_OP:
+        case DWORDFIELD_OP:
+        case QWORDFIELD_OP:
+            if (lai_verify_term(v, pc, limit, LAI_REFERENCE_MODE)
+                || lai_verify_term(v, pc, limit, LAI_OBJECT_MODE)
+                || lai_verify_term(v, pc, limit, LAI_UNRESOLVED_MODE))
+                return 1;
+            break;
+        case (EXTOP_PREFIX << 8) | ARBFIELD_OP:
+            if (lai_verify_term(v, pc, limit, LAI_REFERENCE_MODE)
+                || lai_verify_term(v, pc, limit, LAI_OBJECT_MODE)
+                || lai_verify_term(v, pc, limit, LAI_OBJECT_MODE)
+                || lai_verify_term(v, pc, limit, LAI_UNRESOLVED_MODE))
+                return 1;
+            break;
+        case (EXTOP_PREFIX << 8) | MUTEX:
+            if (lai_verify_name(v, pc, limit)
+                || lai_verify_term(v, pc, limit, LAI_IMMEDIATE_BYTE_MODE))
+                return 1;
+            break;
+        case (EXTOP_PREFIX << 8) | EVENT:
+            if (lai_verify_name(v, pc, limit))
+                return 1;
+            break;
+        case (EXTOP_PREFIX << 8) | OPREGION:
+            if (lai_verify_name(v, pc, limit) || *pc >= limit)
+                return 1;
+            lai_verify_add_space(v, code[(*pc)++]);
+            if (lai_verify_term(v, pc, limit, LAI_OBJECT_MODE)
+                || lai_verify_term(v, pc, limit, LAI_OBJECT_MODE))
+                return 1;
+            break;
+        case (EXTOP_PREFIX << 8) | FIELD:
+            if (lai_verify_pkglength(v, ext_pc, pc, limit, &end)
+                || lai_verify_field_source(v, pc, end))
+                return 1;
+            *pc = end;
+            break;
+        case (EXTOP_PREFIX << 8) | INDEXFIELD:
+        case (EXTOP_PREFIX << 8) | BANKFIELD:
+            // The BankValue of BankField() is not checked.
+            if (lai_verify_pkglength(v, ext_pc, pc, limit, &end)
+                || lai_verify_field_source(v, pc, end) || lai_verify_field_source(v, pc, end))
+                return 1;
+            *pc = end;
+            break;
+        case METHOD_OP:
+            // The nested method is analyzed on its own.
+            if (lai_verify_pkglength(v, opcode_pc, pc, limit, &end))
+                return 1;
+            *pc = end;
+            break;
+        case SCOPE_OP:
+        case (EXTOP_PREFIX << 8) | DEVICE:
+        case (EXTOP_PREFIX << 8) | PROCESSOR:
+        case (EXTOP_PREFIX << 8) | POWER_RES:
+        case (EXTOP_PREFIX << 8) | THERMALZONE:
+            // Names in the body resolve relative to the new scope. It is not analyzed.
+            if (lai_verify_pkglength(v, (opcode == SCOPE_OP) ? opcode_pc : ext_pc, pc, limit,
+                                     &end))
+                return 1;
+            v->info->flags |= LAI_METHOD_INCOMPLETE;
+            *pc = end;
+            break;
+        default:
+            return 1;
+    }
+    v->info->flags |= LAI_METHOD_CREATES_NODES;
+    return 0;
+}
+
+// Returns true if evaluating the node does not access hardware.
+static int lai_verify_is_constant(lai_nsnode_t *node) {
+    switch (node->type) {
+        case LAI_NAMESPACE_NAME:
+        case LAI_NAMESPACE_DEVICE:
+        case LAI_NAMESPACE_PROCESSOR:
+        case LAI_NAMESPACE_THERMALZONE:
+        case LAI_NAMESPACE_POWERRESOURCE:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static int lai_verify_term_at(struct lai_verifier *v, int *pc, int limit, int mode) {
+    uint8_t *code = v->code;
+    if (mode == LAI_IMMEDIATE_BYTE_MODE || mode == LAI_IMMEDIATE_WORD_MODE
+        || mode == LAI_IMMEDIATE_DWORD_MODE) {
+        int size = (mode == LAI_IMMEDIATE_BYTE_MODE)   ? 1
+                   : (mode == LAI_IMMEDIATE_WORD_MODE) ? 2
+                                                       : 4;
+        if (limit - *pc < size)
+            return 1;
+        *pc += size;
+        return 0;
+    }
+
+    if (lai_is_name(code[*pc])) {
+        struct lai_amlname amln;
+        int name_pc = *pc;
+        if (lai_verify_name(v, pc, limit))
+            return 1;
+        // Names in packages are not evaluated. Names of new nodes cannot be resolved.
+        if (mode == LAI_DATA_MODE)
+            return 0;
+        if (mode == LAI_UNRESOLVED_MODE) {
+            v->impure = 1;
+            return 0;
+        }
+
+        // Names that are not evaluated are targets (or references).
+        int invoke = lai_mode_flags[mode] & LAI_MF_INVOKE;
+        if (!invoke)
+            v->impure = 1;
+
+        // Invocations consume arguments. Names that cannot be resolved make the
+        // engine fail (as long as the namespace does not change).
+        lai_amlname_parse(&amln, code + name_pc);
+        lai_nsnode_t *handle = lai_do_resolve(v->method, &amln);
+        if (!handle) {
+            v->impure = 1;
+            return 0;
+        }
+        if (handle->type == LAI_NAMESPACE_NAME)
+            v->reads_variables = 1;
+        lai_verify_add_field(v, handle);
+        if (!invoke)
+            return 0;
+        if (handle->type != LAI_NAMESPACE_METHOD) {
+            if (!lai_verify_is_constant(handle))
+                v->impure = 1;
+            return 0;
+        }
+        v->info->flags |= LAI_METHOD_INVOKES;
+        if (!lai_method_is_pure(handle))
+            v->impure = 1;
+        int argc = handle->method_flags & METHOD_ARGC_MASK;
+        for (int i = 0; i < argc; i++) {
+            if (lai_verify_term(v, pc, limit, LAI_OBJECT_MODE))
+                return 1;
+        }
+        return 0;
+    }
+
+    return lai_verify_opcode(v, pc, limit, mode);
+}
+
+static int lai_verify_term(struct lai_verifier *v, int *pc, int limit, int mode) {
+    if (*pc >= limit || v->depth == LAI_VERIFY_MAX_DEPTH)
+        return 1;
+    v->depth++;
+    if (v->info->max_term_depth < v->depth)
+        v->info->max_term_depth = v->depth;
+    int failed = lai_verify_term_at(v, pc, limit, mode);
+    v->depth--;
+    return failed;
+}
+
+static void lai_verify_run(lai_nsnode_t *method, struct lai_method_info *info) {
+    LAI_ENSURE(method->type == LAI_NAMESPACE_METHOD);
+    memset(info, 0, sizeof(struct lai_method_info));
+    if (method->method_override || !method->pointer) {
+        info->flags = LAI_METHOD_INCOMPLETE;
+        return;
+    }
+
+    struct lai_verifier v = {0};
+    v.method = method;
+    v.code = method->pointer;
+    v.info = info;
+    if (lai_verify_terms(&v, 0, method->size, LAI_EXEC_MODE)) {
+        info->flags |= LAI_METHOD_INCOMPLETE;
+        return;
+    }
+    if (info->flags & LAI_METHOD_CREATES_NODES)
+        return;
+    info->flags |= LAI_METHOD_VERIFIED;
+    if (!v.impure)
+        info->flags |= LAI_METHOD_PURE;
+}
+
+int lai_verify_method(lai_nsnode_t *method) {
+    struct lai_method_info info;
+    lai_verify_run(method, &info);
+    return !(info.flags & LAI_METHOD_VERIFIED);
+}
+
+static void lai_verify_analyze(lai_nsnode_t *method, struct lai_method_info *info) {
+    // Mark the method as unverified and impure during the run. That way, recursive
+    // invocations are treated as impure.
+    method->mth_verify_generation = lai_current_instance()->ns_generation;
+    method->mth_flags = 0;
+
+    lai_verify_run(method, info);
+    method->mth_flags = info->flags;
+}
+
+static void lai_verify_update(lai_nsnode_t *method) {
+    if (method->mth_verify_generation == lai_current_instance()->ns_generation)
+        return;
+    struct lai_method_info info;
+    lai_verify_analyze(method, &info);
+}
+
+unsigned int lai_verified_generation(lai_nsnode_t *method) {
+    lai_verify_update(method);
+    if (!(method->mth_flags & LAI_METHOD_VERIFIED))
+        return 0;
+    return lai_current_instance()->ns_generation;
+}
+
+int lai_method_is_pure(lai_nsnode_t *method) {
+    lai_verify_update(method);
+    return method->mth_flags & LAI_METHOD_PURE;
+}
+
+void lai_verify_namespace(void) {
+    struct lai_instance *instance = lai_current_instance();
+    size_t num_verified = 0;
+    size_t num_methods = 0;
+    for (size_t i = 0; i < instance->ns_size; i++) {
+        lai_nsnode_t *node = instance->ns_array[i];
+        if (!node || node->type != LAI_NAMESPACE_METHOD || node->method_override)
+            continue;
+        num_methods++;
+        if (lai_verified_generation(node))
+            num_verified++;
+    }
+    lai_debug("verified %lu of %lu control methods", num_verified, num_methods);
+}
+
+lai_api_error_t lai_analyze_method(lai_nsnode_t *method, struct lai_method_info *info) {
+    if (method->type != LAI_NAMESPACE_METHOD)
+        return LAI_ERROR_TYPE_MISMATCH;
+    lai_verify_analyze(method, info);
+    return LAI_ERROR_NONE;
+}
+
+void lai_dump_method_analysis(void) {
+    struct lai_instance *instance = lai_current_instance();
+    for (size_t i = 0; i < instance->ns_size; i++) {
+        lai_nsnode_t *node = instance->ns_array[i];
+        if (!node || node->type != LAI_NAMESPACE_METHOD || node->method_override)
+            continue;
+        struct lai_method_info info;
+        lai_analyze_method(node, &info);
+
+        char spaces[64] = "";
+        size_t n = 0;
+        for (int space = 0; space < 256; space++) {
+            if (!(info.region_spaces[space >> 5] & ((uint32_t)1 << (space & 31))))
+                continue;
+            const char *sep = n ? "," : " regions=";
+            const char *name = lai_stringify_address_space(space);
+            if (name)
+                lai_snprintf(spaces + n, sizeof(spaces) - n, "%s%s", sep, name);
+            else
+                lai_snprintf(spaces + n, sizeof(spaces) - n, "%s0x%02X", sep, space);
+            n = lai_strlen(spaces);
+        }
+
+        unsigned int flags = info.flags;
+        LAI_CLEANUP_FREE_STRING char *path = lai_stringify_node_path(node);
+        lai_debug("%s: depth=%d/%d%s%s%s%s%s%s%s%s%s", path, info.max_block_depth,
+                  info.max_term_depth, (flags & LAI_METHOD_VERIFIED) ? " verified" : "",
+                  (flags & LAI_METHOD_PURE) ? " pure" : "", spaces,
+                  (flags & LAI_METHOD_SLEEPS) ? " sleeps" : "",
+                  (flags & LAI_METHOD_WAITS) ? " waits" : "",
+                  (flags & LAI_METHOD_CREATES_NODES) ? " creates" : "",
+                  (flags & LAI_METHOD_UNBOUNDED_LOOP) ? " unbounded" : "",
+                  (flags & LAI_METHOD_INVOKES) ? " invokes" : "",
+                  (flags & LAI_METHOD_INCOMPLETE) ? " incomplete" : "");
+    }
+}
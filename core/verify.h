@@ -0,0 +1,36 @@
+/*
+ * Lightweight AML Interpreter
+ * Copyright (C) 2018-2023 The lai authors
+ */
+
+// Internal header file. Do not use outside of LAI.
+
+#pragma once
+
+#include <lai/core.h>
+
+// Verification of control methods, see lai_enable_verifier().
+//
+// The verifier decodes a method body once and checks that every opcode is known, that names
+// are well-formed, that immediates and strings fit into the method and that PkgLengths nest
+// properly. The code of verified methods is then decoded without bounds checks.
+//
+// Whether a name is invoked (and with how many arguments) depends on the namespace. Hence,
+// results are only valid as long as lai_current_instance()->ns_generation does not change.
+// The same walk also computes the classification that lai_analyze_method() reports.
+
+// Returns zero if the method passes verification.
+int lai_verify_method(lai_nsnode_t *method);
+
+// Like lai_verify_method() but caches the result until the namespace changes.
+// Returns the current namespace generation if the method is verified and zero otherwise.
+unsigned int lai_verified_generation(lai_nsnode_t *method);
+
+// Returns true if the method only computes a value from its arguments and from Name() objects.
+// In particular, it does not store to named objects or through references, it does not access
+// hardware or synchronization objects and it does not create namespace nodes. All methods
+// that it invokes are pure as well. Like lai_verified_generation(), results are cached.
+int lai_method_is_pure(lai_nsnode_t *method);
+
+// Verifies all methods in the namespace. Called once all tables are loaded.
+void lai_verify_namespace(void);
@@ -53,13 +53,13 @@ void lai_init_ec(lai_nsnode_t *node, struct lai_ec_driver *driver) {
         return;
     }
 
-    LAI_CLEANUP_VAR lai_variable_t crs = LAI_VAR_INITIALIZER;
-    if (lai_eval(&crs, crs_node, &state)) {
+    LAI_CLEANUP_EVAL_VIEW struct lai_eval_view crs = LAI_EVAL_VIEW_INITIALIZER;
+    if (lai_eval_view(&crs, crs_node, &state, 0, NULL)) {
         lai_warn("Couldn't eval _CRS for initializing EC driver");
         return;
     }
 
-    struct lai_resource_view crs_it = LAI_RESOURCE_VIEW_INITIALIZER(&crs);
+    struct lai_resource_view crs_it = LAI_RESOURCE_VIEW_INITIALIZER(&crs.object);
     lai_api_error_t error;
 
     error = lai_resource_iterate(&crs_it);
@@ -52,14 +52,14 @@ lai_api_error_t lai_pci_route_pin(acpi_resource_t *dest, uint16_t seg, uint8_t b
         return LAI_ERROR_NO_SUCH_NODE;
     }
 
-    LAI_CLEANUP_VAR lai_variable_t prt = LAI_VAR_INITIALIZER;
+    LAI_CLEANUP_EVAL_VIEW struct lai_eval_view prt = LAI_EVAL_VIEW_INITIALIZER;
 
-    if (lai_eval(&prt, prt_handle, &state)) {
+    if (lai_eval_view(&prt, prt_handle, &state, 0, NULL)) {
         lai_warn("failed to evaluate _PRT");
         return LAI_ERROR_EXECUTION_FAILURE;
     }
 
-    struct lai_prt_iterator iter = LAI_PRT_ITERATOR_INITIALIZER(&prt);
+    struct lai_prt_iterator iter = LAI_PRT_ITERATOR_INITIALIZER(&prt.object);
     lai_api_error_t err;
 
     while (!(err = lai_pci_parse_prt(&iter))) {
@@ -142,13 +142,13 @@ lai_api_error_t lai_pci_parse_prt(struct lai_prt_iterator *iter) {
         if (!crs_handle)
             return LAI_ERROR_UNEXPECTED_RESULT;
 
-        LAI_CLEANUP_VAR lai_variable_t crs_buffer = LAI_VAR_INITIALIZER;
-        int status = lai_eval(&crs_buffer, crs_handle, &state);
+        LAI_CLEANUP_EVAL_VIEW struct lai_eval_view crs_buffer = LAI_EVAL_VIEW_INITIALIZER;
+        int status = lai_eval_view(&crs_buffer, crs_handle, &state, 0, NULL);
         if (status)
             return LAI_ERROR_EXECUTION_FAILURE;
 
         // Find the _CRS entry based on its index.
-        struct lai_resource_view view = LAI_RESOURCE_VIEW_INITIALIZER(&crs_buffer);
+        struct lai_resource_view view = LAI_RESOURCE_VIEW_INITIALIZER(&crs_buffer.object);
         unsigned int current = 0;
         while (!lai_resource_iterate(&view)) {
             if (current == res_index) {
@@ -52,19 +52,19 @@ lai_api_error_t lai_enter_sleep(uint8_t sleep_state) {
         return LAI_ERROR_UNSUPPORTED;
     }
 
-    LAI_CLEANUP_VAR lai_variable_t package = LAI_VAR_INITIALIZER;
+    LAI_CLEANUP_EVAL_VIEW struct lai_eval_view package = LAI_EVAL_VIEW_INITIALIZER;
     LAI_CLEANUP_VAR lai_variable_t slp_typa = LAI_VAR_INITIALIZER;
     LAI_CLEANUP_VAR lai_variable_t slp_typb = LAI_VAR_INITIALIZER;
     int eval_status;
-    eval_status = lai_eval(&package, handle, &state);
+    eval_status = lai_eval_view(&package, handle, &state, 0, NULL);
     if (eval_status) {
         lai_debug("sleep state S%d is not supported.", sleep_state);
         return LAI_ERROR_UNSUPPORTED;
     }
 
     lai_debug("entering sleep state S%d...", sleep_state);
-    lai_obj_get_pkg(&package, 0, &slp_typa);
-    lai_obj_get_pkg(&package, 1, &slp_typb);
+    lai_obj_get_pkg(&package.object, 0, &slp_typa);
+    lai_obj_get_pkg(&package.object, 1, &slp_typb);
 
     // ACPI spec says we should call _PTS() and _GTS() before actually sleeping
     // Who knows, it might do some required firmware-specific stuff
@@ -34,20 +34,20 @@ size_t lai_read_resource(lai_nsnode_t *device, acpi_resource_t *dest) {
     if (!crs_handle)
         return 0;
 
-    LAI_CLEANUP_VAR lai_variable_t buffer = LAI_VAR_INITIALIZER;
-    int status = lai_eval(&buffer, crs_handle, &state);
+    LAI_CLEANUP_EVAL_VIEW struct lai_eval_view buffer = LAI_EVAL_VIEW_INITIALIZER;
+    int status = lai_eval_view(&buffer, crs_handle, &state, 0, NULL);
     if (status)
         return 0;
 
     // read the resource buffer
     size_t count = 0;
-    uint8_t *data = lai_exec_buffer_access(&buffer);
+    const uint8_t *data = lai_exec_buffer_view(&buffer.object);
     size_t data_size;
 
-    acpi_small_irq_t *small_irq;
+    const acpi_small_irq_t *small_irq;
     uint16_t small_irq_mask;
 
-    acpi_large_irq_t *large_irq;
+    const acpi_large_irq_t *large_irq;
 
     size_t i;
 
@@ -61,7 +61,7 @@ size_t lai_read_resource(lai_nsnode_t *device, acpi_resource_t *dest) {
                     return count;
 
                 case ACPI_SMALL_IRQ:
-                    small_irq = (acpi_small_irq_t *)&data[0];
+                    small_irq = (const acpi_small_irq_t *)&data[0];
                     small_irq_mask = small_irq->irq_mask;
 
                     i = 0;
@@ -100,7 +100,7 @@ size_t lai_read_resource(lai_nsnode_t *device, acpi_resource_t *dest) {
 
             switch (data[0]) {
                 case ACPI_LARGE_IRQ:
-                    large_irq = (acpi_large_irq_t *)&data[0];
+                    large_irq = (const acpi_large_irq_t *)&data[0];
 
                     dest[count].type = ACPI_RESOURCE_IRQ;
                     dest[count].base = (uint64_t)large_irq->irq;
@@ -127,7 +127,7 @@ struct lai_resource_header_info {
     size_t skip_size;
 };
 
-static struct lai_resource_header_info lai_get_header_info(uint8_t *header_byte) {
+static struct lai_resource_header_info lai_get_header_info(const uint8_t *header_byte) {
     struct lai_resource_header_info info;
     if (!(header_byte[0] & (1 << 7))) { // Small
         info.type = (header_byte[0] >> 3) & 0xF;
@@ -148,7 +148,7 @@ lai_api_error_t lai_resource_iterate(struct lai_resource_view *iterator) {
     iterator->entry += iterator->skip_size;
 
     struct lai_resource_header_info info = lai_get_header_info(iterator->entry);
-    uint8_t *entry = iterator->entry;
+    const uint8_t *entry = iterator->entry;
 
     switch (info.type) {
         case ACPI_SMALL_FIXED_IO:
@@ -203,7 +203,7 @@ lai_api_error_t lai_resource_iterate(struct lai_resource_view *iterator) {
 enum lai_resource_type lai_resource_get_type(struct lai_resource_view *iterator) {
     LAI_ENSURE(iterator);
     LAI_ENSURE(iterator->entry);
-    uint8_t *entry = iterator->entry;
+    const uint8_t *entry = iterator->entry;
 
     struct lai_resource_header_info info = lai_get_header_info(entry);
     switch (info.type) {
@@ -240,7 +240,7 @@ enum lai_resource_type lai_resource_get_type(struct lai_resource_view *iterator)
 int lai_resource_irq_is_level_triggered(struct lai_resource_view *iterator) {
     LAI_ENSURE(iterator);
     LAI_ENSURE(iterator->entry);
-    uint8_t *entry = iterator->entry;
+    const uint8_t *entry = iterator->entry;
 
     struct lai_resource_header_info info = lai_get_header_info(entry);
     switch (info.type) {
@@ -258,7 +258,7 @@ int lai_resource_irq_is_level_triggered(struct lai_resource_view *iterator) {
 int lai_resource_irq_is_active_low(struct lai_resource_view *iterator) {
     LAI_ENSURE(iterator);
     LAI_ENSURE(iterator->entry);
-    uint8_t *entry = iterator->entry;
+    const uint8_t *entry = iterator->entry;
 
     struct lai_resource_header_info info = lai_get_header_info(entry);
     switch (info.type) {
@@ -276,7 +276,7 @@ int lai_resource_irq_is_active_low(struct lai_resource_view *iterator) {
 lai_api_error_t lai_resource_next_irq(struct lai_resource_view *iterator) {
     LAI_ENSURE(iterator);
     LAI_ENSURE(iterator->entry);
-    uint8_t *entry = iterator->entry;
+    const uint8_t *entry = iterator->entry;
 
     struct lai_resource_header_info info = lai_get_header_info(entry);
 
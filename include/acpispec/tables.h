@@ -36,6 +36,11 @@ extern "C" {
 #define ACPI_OPREGION_EC 0x03
 #define ACPI_OPREGION_SMBUS 0x04
 #define ACPI_OPREGION_CMOS 0x05
+#define ACPI_OPREGION_PCI_BAR 0x06
+#define ACPI_OPREGION_IPMI 0x07
+#define ACPI_OPREGION_GPIO 0x08
+#define ACPI_OPREGION_GSB 0x09
+#define ACPI_OPREGION_PCC 0x0A
 #define ACPI_OPREGION_OEM 0x80
 
 typedef struct acpi_rsdp_t {
@@ -29,6 +29,43 @@ extern "C" {
 // Convert a lai_api_error_t to a human readable string
 const char *lai_api_error_to_string(lai_api_error_t);
 
+struct lai_notify_entry {
+    lai_nsnode_t *node;
+    uint64_t value;
+};
+
+// Resolution of a LAI_LAZY_HANDLE, valid while ns_generation is unchanged.
+struct lai_lazy_cache_entry {
+    const uint8_t *aml;
+    uint32_t scope;
+    unsigned int generation;
+    lai_nsnode_t *handle;
+};
+
+#define LAI_LAZY_CACHE_SIZE 64
+
+// Entry of lai_instance::lazy_scopes. The tag is bumped whenever the entry is recycled.
+struct lai_lazy_scope {
+    lai_nsnode_t *node; // NULL if the entry is free.
+    uint32_t tag;
+    uint32_t next_free;
+};
+
+// Addresses of a register that selects the bank of BankFields, see lai_select_bank().
+struct lai_bank_register {
+    uint8_t space;
+    uint64_t start;
+    uint64_t end;
+};
+
+#define LAI_BANK_REGISTERS 4
+
+struct lai_address_space_handler {
+    const struct lai_opregion_override *ops;
+    void *userptr;
+    int warned; // Set once an access without handler was reported.
+};
+
 struct lai_instance {
     lai_nsnode_t *root_node;
 
@@ -38,9 +75,54 @@ struct lai_instance {
 
     int acpi_revision;
     int trace;
+    int ir_flags;
+    int verify_enabled;
+    int memo_enabled;
+    int profile_enabled;
     int is_hw_reduced;
 
     acpi_fadt_t *fadt;
+
+    // Deferred Notify() delivery, see lai_enable_notify_queue().
+    int notify_flags;
+    int eval_depth;
+    struct lai_notify_entry *notify_queue;
+    size_t notify_queue_size;
+    size_t notify_queue_capacity;
+
+    // Bumped whenever cached bank selections become stale, see lai_invalidate_bank_cache().
+    unsigned int bank_generation;
+    struct lai_bank_register bank_registers[LAI_BANK_REGISTERS];
+    int num_bank_registers;
+
+    // Bumped whenever nodes are installed or uninstalled, see lai_enable_verifier() and
+    // lai_ns_resolve_lazy_handle().
+    unsigned int ns_generation;
+    // Bumped by stores to named objects and through Index(), see lai_enable_memoization().
+    unsigned int store_generation;
+
+    // Scopes referenced by LAI_LAZY_HANDLE objects, see lai_ns_intern_lazy_scope().
+    struct lai_lazy_scope *lazy_scopes;
+    size_t lazy_scopes_size;
+    size_t lazy_scopes_capacity;
+    uint32_t lazy_scopes_free; // Position of the first free entry plus one, or zero.
+    // Direct-mapped by the AML of the name, see lai_ns_resolve_lazy_handle().
+    struct lai_lazy_cache_entry lazy_cache[LAI_LAZY_CACHE_SIZE];
+
+    // Interpreter state that is reused by the typed evaluators, see lai_eval_u64().
+    lai_state_t eval_state;
+    int eval_state_initialized;
+    int eval_state_busy;
+
+    // Indexed by the OperationRegion's address space.
+    struct lai_address_space_handler address_space_handlers[256];
+
+    // Receives LAI_TRACE_* events as binary records, see lai_enable_trace_ring().
+    struct lai_trace_ring *trace_ring;
+
+    // Innermost profiled invocation and its statistics, see lai_enable_profiling().
+    struct lai_invocation *profile_invocation;
+    struct lai_profile *profile_current;
 };
 
 struct lai_instance *lai_current_instance();
@@ -89,6 +171,20 @@ void lai_eisaid(lai_variable_t *, const char *);
 lai_nsnode_t *lai_ns_iterate(struct lai_ns_iterator *);
 lai_nsnode_t *lai_ns_child_iterate(struct lai_ns_child_iterator *);
 
+// Paths that are parsed once (e.g., at driver initialization) and resolved repeatedly.
+#define LAI_PATH_MAX_SEGMENTS 8
+
+typedef struct lai_path {
+    int is_absolute;
+    int height; // Number of leading ^.
+    int num_segments;
+    uint32_t segments[LAI_PATH_MAX_SEGMENTS]; // NameSegs, padded with trailing underscores.
+    unsigned int hashes[LAI_PATH_MAX_SEGMENTS];
+} lai_path_t;
+
+lai_api_error_t lai_compile_path(lai_path_t *, const char *);
+lai_nsnode_t *lai_resolve_compiled_path(lai_nsnode_t *, const lai_path_t *);
+
 // Namespace functions.
 
 lai_nsnode_t *lai_ns_get_root();
@@ -97,11 +193,28 @@ lai_nsnode_t *lai_ns_get_child(lai_nsnode_t *parent, const char *name);
 lai_api_error_t lai_ns_override_notify(lai_nsnode_t *node,
                                        lai_api_error_t (*override)(lai_nsnode_t *, int, void *),
                                        void *userptr);
+
+// Notify() queueing. With LAI_NOTIFY_QUEUE, Notify() operations are collected (duplicate
+// (node, value) pairs are coalesced) and delivered in a batch once the outermost evaluation
+// returns. With LAI_NOTIFY_QUEUE_MANUAL in addition, they are only delivered by
+// lai_drain_notify_queue(), e.g. after the host dropped its own locks.
+#define LAI_NOTIFY_QUEUE 1
+#define LAI_NOTIFY_QUEUE_MANUAL 2
+
+void lai_enable_notify_queue(int flags);
+size_t lai_drain_notify_queue(void);
 lai_api_error_t lai_ns_override_opregion(lai_nsnode_t *node,
                                          const struct lai_opregion_override *override,
                                          void *userptr);
 enum lai_node_type lai_ns_get_node_type(lai_nsnode_t *node);
 
+// Installs (or, if ops is NULL, removes) the handler for all OperationRegions of an address
+// space. Per-node overrides take precedence. Evaluates _REG for all affected regions, and for
+// regions that are created later (by lai_populate() or by methods).
+lai_api_error_t lai_install_address_space_handler(uint8_t space,
+                                                  const struct lai_opregion_override *ops,
+                                                  void *userptr);
+
 uint8_t lai_ns_get_opregion_address_space(lai_nsnode_t *node);
 
 // Access and manipulation of lai_variable_t.
@@ -123,6 +236,9 @@ lai_api_error_t lai_create_pkg(lai_variable_t *, size_t);
 enum lai_object_type lai_obj_get_type(lai_variable_t *object);
 lai_api_error_t lai_obj_get_integer(lai_variable_t *, uint64_t *);
 lai_api_error_t lai_obj_get_pkg(lai_variable_t *, size_t, lai_variable_t *);
+// Returns the elements of a package that only contains integers without copying them.
+// The array stays valid until the package is modified or finalized.
+lai_api_error_t lai_obj_get_pkg_u64_array(lai_variable_t *, const uint64_t **, size_t *);
 lai_api_error_t lai_obj_get_handle(lai_variable_t *, lai_nsnode_t **);
 
 lai_api_error_t lai_obj_resize_string(lai_variable_t *, size_t);
@@ -170,6 +286,32 @@ lai_api_error_t lai_eval_largs(lai_variable_t *, lai_nsnode_t *, lai_state_t *,
 lai_api_error_t lai_eval_vargs(lai_variable_t *, lai_nsnode_t *, lai_state_t *, va_list);
 lai_api_error_t lai_eval(lai_variable_t *, lai_nsnode_t *, lai_state_t *);
 
+// Read-only evaluation. For Name()s, the view shares the object in the namespace instead of
+// copying it; method results are handed over as-is. The view must not be modified (it may
+// observe modifications by AML, though). Release it with lai_eval_view_release().
+struct lai_eval_view {
+    lai_variable_t object;
+};
+
+#define LAI_CLEANUP_EVAL_VIEW __attribute__((cleanup(lai_eval_view_release)))
+#define LAI_EVAL_VIEW_INITIALIZER                                                                  \
+    { LAI_VAR_INITIALIZER }
+
+lai_api_error_t lai_eval_view(struct lai_eval_view *, lai_nsnode_t *, lai_state_t *, int,
+                              lai_variable_t *);
+void lai_eval_view_release(struct lai_eval_view *);
+
+// Typed evaluation into caller-provided storage. The path is resolved relative to the node;
+// it may be NULL to evaluate the node itself. Control methods run on an interpreter state that
+// is reused across calls. Return LAI_ERROR_TYPE_MISMATCH if the result has a different type and
+// LAI_ERROR_OUT_OF_BOUNDS if it does not fit into the given storage.
+lai_api_error_t lai_eval_u64(lai_nsnode_t *, const lai_path_t *, uint64_t *);
+// Copies the string including its null terminator.
+lai_api_error_t lai_eval_string_into(lai_nsnode_t *, const lai_path_t *, char *, size_t);
+// Stores the size of the buffer to the last argument (if non-NULL), even if it does not fit.
+lai_api_error_t lai_eval_buffer_into(lai_nsnode_t *, const lai_path_t *, void *, size_t,
+                                     size_t *);
+
 // ACPI Control Methods
 lai_api_error_t lai_populate(lai_nsnode_t *, struct lai_aml_segment *, lai_state_t *);
 
@@ -184,6 +326,137 @@ void lai_set_acpi_revision(int);
 
 void lai_enable_tracing(int trace);
 
+// Events of binary traces, see struct lai_trace_record.
+#define LAI_TRACE_EVENT_OPCODE 1 // An opcode is parsed. node is the scope.
+#define LAI_TRACE_EVENT_NAME 2 // A name is parsed. node is NULL unless the name is resolved.
+#define LAI_TRACE_EVENT_INVOKE 3 // A method invocation is parsed.
+#define LAI_TRACE_EVENT_REDUCE 4 // An operator (or a node-creating opcode) is evaluated.
+#define LAI_TRACE_EVENT_IO_READ 5 // opcode is the access size in bits, node the OperationRegion.
+#define LAI_TRACE_EVENT_IO_WRITE 6
+#define LAI_TRACE_EVENT_IO_BULK_READ 7 // value is the size in bytes.
+#define LAI_TRACE_EVENT_IO_BULK_WRITE 8
+#define LAI_TRACE_EVENT_NS_INSTALL 9 // opcode is the type of the node.
+
+// Fixed-size (32 bytes) record of a traced event.
+struct lai_trace_record {
+    uint64_t timestamp; // laihost_timer() or zero.
+    uint64_t value;
+    uint64_t node; // (uintptr_t) of the lai_nsnode_t.
+    // Offset of the opcode relative to the start of its table (as in 'iasl -l') for parser events
+    // and offset into the OperationRegion for I/O events.
+    uint32_t offset;
+    uint16_t opcode;
+    uint8_t event;
+    uint8_t reserved;
+};
+
+// Single-producer, single-consumer ring of trace records. The memory is provided by the host.
+// LAI advances head and the consumer advances tail; both are only accessed atomically. If the
+// ring is full, new records are dropped (and counted) until the consumer catches up.
+struct lai_trace_ring {
+    struct lai_trace_record *records;
+    size_t size; // Must be a power of two.
+    size_t head;
+    size_t tail;
+    size_t dropped;
+};
+
+#define LAI_TRACE_RING_INITIALIZER(records, size)                                                  \
+    { (records), (size), 0, 0, 0 }
+
+// Appends the events selected by lai_enable_tracing() to the ring instead of formatting them
+// through lai_debug(). Pass NULL to go back to string output.
+void lai_enable_trace_ring(struct lai_trace_ring *);
+
+// Removes up to n records from the ring. May run concurrently to LAI (but not to other
+// consumers). Returns the number of records.
+size_t lai_trace_ring_consume(struct lai_trace_ring *, struct lai_trace_record *, size_t n);
+
+// Formats a record, symbolizing the node against the namespace. Nodes that are no longer part of
+// the namespace (e.g., method-local nodes) are printed as pointers.
+void lai_trace_format(const struct lai_trace_record *, char *, size_t);
+
+// Consumes all records of the ring and logs them, one line per record.
+void lai_trace_dump(struct lai_trace_ring *);
+
+// Runs control methods on a register-based IR instead of the stack-based interpreter if they
+// only use features that the IR supports. Mainly useful for benchmarking and for comparing
+// results of both execution engines: with LAI_IR_COMPARE in addition, methods without side
+// effects (see LAI_METHOD_PURE) are run on both and differing results are reported by lai_warn().
+#define LAI_IR_ENABLE 1
+#define LAI_IR_COMPARE 2
+
+void lai_enable_ir(int flags);
+
+// Verifies the AML of control methods before they run. Verified methods are decoded without
+// per-opcode bounds checks. Should be called before lai_create_namespace() to verify all
+// methods at load time; otherwise, methods are verified on their first invocation.
+void lai_enable_verifier(int enable);
+
+// Caches the results of lai_eval_args() (and friends) for methods without side effects, e.g.,
+// _HID or _PRT methods that only return constants or the contents of Name() objects.
+// Cached results are dropped once the namespace changes or objects are stored to.
+void lai_enable_memoization(int enable);
+
+// Static classification of control methods, see lai_analyze_method().
+#define LAI_METHOD_VERIFIED 1 // Passes verification, see lai_enable_verifier().
+#define LAI_METHOD_PURE 2 // Only computes a value from its arguments and Name() objects.
+#define LAI_METHOD_ACCESSES_REGIONS 4 // Accesses (or creates) OperationRegions.
+#define LAI_METHOD_SLEEPS 8 // Uses Sleep() or Stall().
+#define LAI_METHOD_WAITS 16 // Uses Acquire() or Wait().
+#define LAI_METHOD_CREATES_NODES 32 // Creates namespace nodes.
+#define LAI_METHOD_UNBOUNDED_LOOP 64 // Contains a While() that is not obviously bounded.
+#define LAI_METHOD_INVOKES 128 // Invokes other methods.
+#define LAI_METHOD_INCOMPLETE 256 // Parts of the method could not be analyzed.
+
+struct lai_method_info {
+    unsigned int flags;
+    // Bit n is set if regions in address space n (i.e., ACPI_OPREGION_*) are accessed.
+    uint32_t region_spaces[8];
+    // Maximal nesting of If(), Else() and While() blocks.
+    int max_block_depth;
+    // Maximal nesting of terms (including blocks, operands and arguments).
+    int max_term_depth;
+};
+
+// Analyzes the AML of a control method without running it. Only the method itself is
+// considered (e.g., LAI_METHOD_SLEEPS is not inherited from invoked methods). Results describe
+// what the method may do; they are exact only for verified methods. Returns
+// LAI_ERROR_TYPE_MISMATCH if the node is not a method.
+lai_api_error_t lai_analyze_method(lai_nsnode_t *, struct lai_method_info *);
+
+// Logs the analysis of all control methods, one line per method. Lines are of the form
+// "<path>: depth=<blocks>/<terms>" followed by the flags, e.g., "verified pure regions=mem,io".
+void lai_dump_method_analysis(void);
+
+// Address spaces beyond LAI_PROFILE_SPACES - 1 are counted in the last slot.
+#define LAI_PROFILE_SPACES 16
+
+// Per-method statistics, see lai_enable_profiling(). Times are in units of laihost_timer()
+// (i.e., 100ns) and stay zero if the host does not provide a timer. For recursive methods,
+// inclusive times are counted once per invocation.
+struct lai_profile {
+    uint64_t invocations;
+    uint64_t inclusive_time; // Including invoked methods.
+    uint64_t exclusive_time;
+    uint64_t opcodes; // Including instructions of the IR, see lai_enable_ir().
+    uint64_t allocations;
+    uint64_t region_accesses[LAI_PROFILE_SPACES]; // Indexed by address space.
+};
+
+// Records statistics of control methods while they run. Profiling is only available if LAI is
+// built with LAI_PROFILE defined; otherwise, the hooks in the interpreter compile to nothing.
+void lai_enable_profiling(int enable);
+
+// Returns NULL if the method was not profiled yet.
+struct lai_profile *lai_get_profile(lai_nsnode_t *);
+
+// Zeros the statistics of all methods.
+void lai_profile_reset(void);
+
+// Logs the n methods with the highest exclusive time (or opcode count, without a timer).
+void lai_profile_dump(size_t n);
+
 #ifdef __cplusplus
 }
 #endif
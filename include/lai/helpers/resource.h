@@ -25,6 +25,8 @@ enum lai_resource_type {
 };
 
 struct lai_resource_view {
+    // Points into the _CRS buffer, which may be shared with the AML table (see
+    // lai_exec_buffer_view()). Do not write through it, use lai_resource_view_entry().
     uint8_t *entry;
     size_t skip_size;
     size_t entry_idx;
@@ -44,7 +46,7 @@ struct lai_resource_view {
 
 #define LAI_RESOURCE_VIEW_INITIALIZER(crs)                                                         \
     {                                                                                              \
-        .entry = (uint8_t *)lai_exec_buffer_access(crs), .skip_size = 0, .entry_idx = 0,           \
+        .entry = (uint8_t *)lai_exec_buffer_view(crs), .skip_size = 0, .entry_idx = 0,             \
         .crs_var = crs, .base = 0, .length = 0, .alignment = 0, .flags = 0, .address_space = 0,    \
         .bit_width = 0, .bit_offset = 0, .gsi = 0                                                  \
     }
@@ -54,6 +56,10 @@ inline static void lai_initialize_resource_view(struct lai_resource_view *view,
     *view = (struct lai_resource_view)LAI_RESOURCE_VIEW_INITIALIZER(crs);
 }
 
+inline static const uint8_t *lai_resource_view_entry(struct lai_resource_view *view) {
+    return view->entry;
+}
+
 lai_api_error_t lai_resource_iterate(struct lai_resource_view *);
 
 enum lai_resource_type lai_resource_get_type(struct lai_resource_view *);
@@ -42,49 +42,92 @@ extern "C" {
 #define LAI_BUFFER_INDEX 11
 #define LAI_PACKAGE_INDEX 12
 
+// Objects are stored as a tag and a single 64-bit payload (plus a 32-bit index for the
+// types that need one), such that lai_variable_t only takes 16 bytes. Only the member of the
+// payload that belongs to the type is valid.
 typedef struct lai_variable_t {
     int type;
-    uint64_t integer; // for Name()
+    union {
+        uint32_t index; // LAI_STRING_INDEX, LAI_BUFFER_INDEX and LAI_PACKAGE_INDEX.
+        uint32_t iref_index; // LAI_ARG_REF and LAI_LOCAL_REF.
+        uint32_t unres_scope; // LAI_LAZY_HANDLE, see lai_ns_get_lazy_scope().
+    };
 
     union {
+        uint64_t integer; // for Name()
         struct lai_string_head *string_ptr;
         struct lai_buffer_head *buffer_ptr;
         struct lai_pkg_head *pkg_ptr;
-        struct {
-            struct lai_nsnode *unres_ctx_handle;
-            const uint8_t *unres_aml;
-        };
-        struct { // LAI_ARG_REF and LAI_LOCAL_REF.
-            struct lai_invocation *iref_invocation;
-            int iref_index;
-        };
+        struct lai_nsnode *handle; // LAI_HANDLE and LAI_NODE_REF.
+        const uint8_t *unres_aml; // LAI_LAZY_HANDLE.
+        struct lai_invocation *iref_invocation; // LAI_ARG_REF and LAI_LOCAL_REF.
     };
+} lai_variable_t;
 
-    struct lai_nsnode *handle;
+// The contents of strings, buffers and packages live in a reference counted block.
+// lai_obj_clone() shares this block between the copies (copy-on-write); it is only duplicated
+// once one of the copies is modified, see lai_exec_{string,buffer,pkg}_unshare().
+struct lai_storage {
+    lai_rc_t rc;
+    size_t size; // In bytes, not including this header.
+};
 
-    int index;
-} lai_variable_t;
+// Small strings and buffers are stored inline, directly after their head. This way, they only
+// take a single allocation. Inline contents are never shared; storage is NULL for them.
+#define LAI_SMALL_OBJECT_SIZE 32
 
 struct lai_string_head {
     lai_rc_t rc;
+    unsigned int inline_size; // Size of the inline area after the head (zero if there is none).
     size_t capacity;
     char *content;
+    struct lai_storage *storage;
 };
 
+// Buffers created from AML literals can also borrow their contents from the (read-only) AML
+// table. Such buffers have neither storage nor an inline area; they are copied on first write.
 struct lai_buffer_head {
     lai_rc_t rc;
+    unsigned int inline_size; // Size of the inline area after the head (zero if there is none).
     size_t size;
     uint8_t *content;
+    struct lai_storage *storage;
 };
 
+// Packages that only contain integers can be stored as a plain array of uint64_t ("packed").
+// lai_exec_pkg_var_load() boxes their elements on demand; storing any other type of object
+// converts the package back to an array of lai_variable_t, see lai_exec_pkg_unpack().
 struct lai_pkg_head {
     lai_rc_t rc;
     unsigned int size;
-    struct lai_variable_t *elems;
+    union {
+        struct lai_variable_t *elems;
+        uint64_t *packed_elems; // If packed is set.
+    };
+    struct lai_storage *storage;
+    int packed;
 };
 
+// Make sure that the object's contents are not shared with other objects before modifying them.
+void lai_exec_string_unshare(struct lai_string_head *head);
+void lai_exec_buffer_unshare(struct lai_buffer_head *head);
+void lai_exec_pkg_unshare(struct lai_pkg_head *head);
+
+// Converts a packed package to an array of lai_variable_t.
+void lai_exec_pkg_unpack(struct lai_pkg_head *head);
+
 // Allows access to the contents of a string.
+// As the caller may write to the string, this unshares its contents.
 __attribute__((always_inline)) inline char *lai_exec_string_access(lai_variable_t *str) {
+    LAI_ENSURE(str->type == LAI_STRING);
+    if (str->string_ptr->storage && str->string_ptr->storage->rc > 1)
+        lai_exec_string_unshare(str->string_ptr);
+    return str->string_ptr->content;
+}
+
+// Allows read-only access to the contents of a string. Unlike lai_exec_string_access(),
+// this never copies contents that are shared.
+__attribute__((always_inline)) inline const char *lai_exec_string_view(lai_variable_t *str) {
     LAI_ENSURE(str->type == LAI_STRING);
     return str->string_ptr->content;
 }
@@ -99,7 +142,18 @@ __attribute__((always_inline)) inline size_t lai_exec_buffer_size(lai_variable_t
 }
 
 // Allows access to the contents of a buffer.
+// As the caller may write to the buffer, this unshares its contents.
 __attribute__((always_inline)) inline void *lai_exec_buffer_access(lai_variable_t *buffer) {
+    LAI_ENSURE(buffer->type == LAI_BUFFER);
+    struct lai_buffer_head *head = buffer->buffer_ptr;
+    if (head->storage ? head->storage->rc > 1 : !head->inline_size)
+        lai_exec_buffer_unshare(head);
+    return buffer->buffer_ptr->content;
+}
+
+// Allows read-only access to the contents of a buffer. Unlike lai_exec_buffer_access(),
+// this never copies contents that are shared (or borrowed from the AML table).
+__attribute__((always_inline)) inline const void *lai_exec_buffer_view(lai_variable_t *buffer) {
     LAI_ENSURE(buffer->type == LAI_BUFFER);
     return buffer->buffer_ptr->content;
 }
@@ -170,6 +224,7 @@ struct lai_operand {
 #define LAI_RETURN_STACKITEM 10 // Parse a return operand
 #define LAI_BANKFIELD_STACKITEM 11 // Parse a BankValue and FieldList
 #define LAI_VARPACKAGE_STACKITEM 12
+#define LAI_MATERIALIZE_STACKITEM 13 // Parse the initializer of a lazy Name().
 
 struct lai_invocation {
     lai_variable_t arg[7];
@@ -177,6 +232,17 @@ struct lai_invocation {
 
     // Stores a list of all namespace nodes created by this method.
     struct lai_list per_method_list;
+
+    // Method-local namespace nodes, see lai_ns_enter_invocation().
+    struct lai_list local_list;
+    struct lai_nsnode *local_scope; // The method itself.
+    struct lai_invocation *outer_invocation; // Enclosing invocation of the same method.
+
+    // See lai_enable_profiling(). prof_record is NULL if the invocation is not profiled.
+    struct lai_profile *prof_record;
+    struct lai_invocation *prof_caller;
+    uint64_t prof_start;
+    uint64_t prof_callee_time; // Inclusive time of invoked methods.
 };
 
 struct lai_ctxitem {
@@ -184,6 +250,8 @@ struct lai_ctxitem {
     uint8_t *code;
     struct lai_nsnode *handle; // Context handle for relative AML names.
     struct lai_invocation *invocation;
+    // Namespace generation in which the code was verified (or zero), see lai_enable_verifier().
+    unsigned int verified_generation;
 };
 
 // The block stack stores a program counter (PC) and PC limit.
@@ -35,6 +35,11 @@ struct lai_opregion_override {
     void (*writew)(uint64_t, uint16_t, void *);
     void (*writed)(uint64_t, uint32_t, void *);
     void (*writeq)(uint64_t, uint64_t, void *);
+
+    // Optional. Transfer len contiguous bytes starting at the given address in one go.
+    // Used for AnyAcc and ByteAcc fields that consist of whole access units only.
+    void (*read_bulk)(uint64_t, void *, size_t, void *);
+    void (*write_bulk)(uint64_t, const void *, size_t, void *);
 };
 
 enum lai_node_type {
@@ -90,6 +95,20 @@ typedef struct lai_nsnode {
     union {
         struct lai_nsnode *al_target; // LAI_NAMESPACE_ALIAS.
 
+        struct { // LAI_NAMESPACE_METHOD
+            struct lai_invocation *mth_invocation; // Innermost invocation (if running).
+            struct lai_ir_method *mth_ir; // See lai_enable_ir().
+            unsigned int mth_ir_generation; // Namespace generation that mth_ir was translated for.
+            unsigned int mth_verify_generation; // See lai_verified_generation().
+            unsigned int mth_flags; // LAI_METHOD_* flags, see lai_analyze_method().
+            struct lai_memo *mth_memo; // See lai_enable_memoization().
+            struct lai_profile *mth_profile; // See lai_enable_profiling().
+        };
+
+        struct { // LAI_NAMESPACE_NAME whose initializer (at pointer) was not parsed yet.
+            struct lai_nsnode *name_lazy_ctx; // Scope that contains the Name().
+        };
+
         struct { // LAI_NAMESPACE_FIELD and LAI_NAMESPACE_BANK_FIELD and LAI_NAMESPACE_INDEX_FIELD
             struct lai_nsnode *fld_region_node;
             uint64_t fld_offset; // In bits.
@@ -106,6 +125,11 @@ typedef struct lai_nsnode {
                     struct lai_nsnode *fld_idxf_index_node;
                     struct lai_nsnode *fld_idxf_data_node;
                 };
+
+                struct { // LAI_NAMESPACE_FIELD that is used as a bank register.
+                    uint64_t fld_bank_selected;
+                    unsigned int fld_bank_generation;
+                };
             };
         };
         struct { // LAI_NAMESPACE_BUFFER_FIELD.
@@ -124,6 +148,7 @@ typedef struct lai_nsnode {
             uint64_t op_length;
             const struct lai_opregion_override *op_override;
             void *op_userptr;
+            int op_connected; // Whether _REG(space, 1) was evaluated for the region.
         };
         struct { // LAI_NAMESPACE_MUTEX
             struct lai_sync_state mut_sync;
@@ -133,9 +158,16 @@ typedef struct lai_nsnode {
         };
     };
 
+    // Index into lai_instance::lazy_scopes, or zero, see lai_ns_intern_lazy_scope().
+    uint32_t lazy_scope;
+
     // Stores a list of all namespace nodes created by the same method.
     struct lai_list_item per_method_item;
 
+    // Set once a reference (LAI_NODE_REF or LAI_HANDLE) to the node was created. Method-local
+    // nodes with references are not freed, see lai_ns_leave_invocation().
+    int referenced;
+
     // Hash table that stores the children of each node.
     struct lai_hashtable children;
 } lai_nsnode_t;
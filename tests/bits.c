@@ -0,0 +1,67 @@
+/*
+ * Lightweight AML Interpreter
+ * Copyright (C) 2018-2023 The lai authors
+ */
+
+// The word-at-a-time kernels in core/util-bits.h, compared to a bit-by-bit reference.
+
+#include <string.h>
+
+#include "../core/util-bits.h"
+#include "test.h"
+
+#define MAX_SIZE 17
+
+static uint64_t random_state = 0x123456789ABCDEF;
+
+static uint64_t random_u64(void) {
+    random_state = random_state * 6364136223846793005 + 1442695040888963407;
+    return random_state;
+}
+
+static uint64_t ref_get(const uint8_t *data, size_t bit_offset, size_t num_bits) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < num_bits; i++) {
+        size_t bit = bit_offset + i;
+        value |= (uint64_t)((data[bit / 8] >> (bit & 7)) & 1) << i;
+    }
+    return value;
+}
+
+static void ref_put(uint8_t *data, size_t bit_offset, size_t num_bits, uint64_t value) {
+    for (size_t i = 0; i < num_bits; i++) {
+        size_t bit = bit_offset + i;
+        data[bit / 8] &= ~(1 << (bit & 7));
+        data[bit / 8] |= ((value >> i) & 1) << (bit & 7);
+    }
+}
+
+int main(void) {
+    uint8_t data[MAX_SIZE];
+    for (size_t i = 0; i < MAX_SIZE; i++)
+        data[i] = random_u64() >> 56;
+
+    for (size_t size = 1; size <= MAX_SIZE; size++) {
+        for (size_t bit_offset = 0; bit_offset < size * 8; bit_offset++) {
+            for (size_t num_bits = 1; num_bits <= 64 && bit_offset + num_bits <= size * 8;
+                 num_bits++) {
+                // Bytes past the end must neither show up in results nor be overwritten.
+                uint8_t copy[MAX_SIZE + 8];
+                memcpy(copy, data, size);
+                memset(copy + size, 0xA5, sizeof(copy) - size);
+                TEST_CHECK(lai_bits_get(copy, size, bit_offset, num_bits)
+                           == ref_get(copy, bit_offset, num_bits));
+
+                uint64_t value = random_u64();
+                uint8_t expected[MAX_SIZE + 8];
+                memcpy(expected, copy, sizeof(copy));
+                ref_put(expected, bit_offset, num_bits, value);
+                lai_bits_put(copy, size, bit_offset, num_bits, value);
+                TEST_CHECK(!memcmp(copy, expected, sizeof(copy)));
+                if (test_failures)
+                    return test_finish();
+            }
+        }
+    }
+    return test_finish();
+}
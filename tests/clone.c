@@ -0,0 +1,91 @@
+/*
+ * Lightweight AML Interpreter
+ * Copyright (C) 2018-2023 The lai authors
+ */
+
+// Clones of strings, buffers and packages share their contents until one of them is modified.
+
+#include <string.h>
+
+#include <lai/internal-exec.h>
+
+#include "test.h"
+
+/*
+ * Name (GSTR, "abcd")
+ * Name (GBUF, Buffer (4) {1, 2, 3, 4})
+ * Name (GPKG, Package (2) {1, Package (2) {2, 3}})
+ * Method (CBUF) {
+ *     Store (GBUF, Local0)
+ *     Store (0x55, Index (Local0, 0))
+ *     Return (Or (ShiftLeft (DerefOf (Index (GBUF, 0)), 8), DerefOf (Index (Local0, 0))))
+ * }
+ * Method (CPKG) {
+ *     Store (GPKG, Local0)
+ *     Store (7, Index (Local0, 0))
+ *     Store (DerefOf (Index (Local0, 1)), Local1)
+ *     Store (9, Index (Local1, 0))
+ *     Return (DerefOf (Index (GPKG, 0)) + (DerefOf (Index (DerefOf (Index (GPKG, 1)), 0)) << 4)
+ *             + (DerefOf (Index (Local0, 0)) << 8) + (DerefOf (Index (Local1, 0)) << 12))
+ * }
+ */
+static const uint8_t aml[] = {
+    0x08, 0x47, 0x53, 0x54, 0x52, 0x0d, 0x61, 0x62, 0x63, 0x64, 0x00, 0x08,
+    0x47, 0x42, 0x55, 0x46, 0x11, 0x07, 0x0a, 0x04, 0x01, 0x02, 0x03, 0x04,
+    0x08, 0x47, 0x50, 0x4b, 0x47, 0x12, 0x0a, 0x02, 0x01, 0x12, 0x06, 0x02,
+    0x0a, 0x02, 0x0a, 0x03, 0x14, 0x27, 0x43, 0x42, 0x55, 0x46, 0x00, 0x70,
+    0x47, 0x42, 0x55, 0x46, 0x60, 0x70, 0x0a, 0x55, 0x88, 0x60, 0x00, 0x00,
+    0xa4, 0x7d, 0x79, 0x83, 0x88, 0x47, 0x42, 0x55, 0x46, 0x00, 0x00, 0x0a,
+    0x08, 0x00, 0x83, 0x88, 0x60, 0x00, 0x00, 0x00, 0x14, 0x43, 0x05, 0x43,
+    0x50, 0x4b, 0x47, 0x00, 0x70, 0x47, 0x50, 0x4b, 0x47, 0x60, 0x70, 0x0a,
+    0x07, 0x88, 0x60, 0x00, 0x00, 0x70, 0x83, 0x88, 0x60, 0x01, 0x00, 0x61,
+    0x70, 0x0a, 0x09, 0x88, 0x61, 0x00, 0x00, 0xa4, 0x72, 0x72, 0x83, 0x88,
+    0x47, 0x50, 0x4b, 0x47, 0x00, 0x00, 0x79, 0x83, 0x88, 0x83, 0x88, 0x47,
+    0x50, 0x4b, 0x47, 0x01, 0x00, 0x00, 0x00, 0x0a, 0x04, 0x00, 0x00, 0x72,
+    0x79, 0x83, 0x88, 0x60, 0x00, 0x00, 0x0a, 0x08, 0x00, 0x79, 0x83, 0x88,
+    0x61, 0x00, 0x00, 0x0a, 0x0c, 0x00, 0x00, 0x00,
+};
+
+// Evaluates a Name into a clone. Only the head of the clone should be allocated.
+static void test_eval_clone(lai_variable_t *result, const char *path) {
+    LAI_CLEANUP_STATE lai_state_t state;
+    lai_init_state(&state);
+    size_t allocations = test_allocations;
+    TEST_CHECK(lai_eval(result, lai_resolve_path(NULL, path), &state) == LAI_ERROR_NONE);
+    TEST_CHECK(test_allocations - allocations <= 1);
+}
+
+int main(void) {
+    test_load(aml, sizeof(aml));
+
+    // Names are materialized on first use, which allocates their contents.
+    TEST_CHECK(lai_objecttype_ns(lai_resolve_path(NULL, "\\GSTR")) == 2);
+    TEST_CHECK(lai_objecttype_ns(lai_resolve_path(NULL, "\\GBUF")) == 3);
+    TEST_CHECK(lai_objecttype_ns(lai_resolve_path(NULL, "\\GPKG")) == 4);
+
+    // Writing to a clone leaves the Name unchanged.
+    LAI_CLEANUP_VAR lai_variable_t str = LAI_VAR_INITIALIZER;
+    test_eval_clone(&str, "\\GSTR");
+    lai_exec_string_access(&str)[0] = 'x';
+    LAI_CLEANUP_VAR lai_variable_t str2 = LAI_VAR_INITIALIZER;
+    test_eval_clone(&str2, "\\GSTR");
+    TEST_CHECK(!strcmp(lai_exec_string_view(&str), "xbcd"));
+    TEST_CHECK(!strcmp(lai_exec_string_view(&str2), "abcd"));
+
+    LAI_CLEANUP_VAR lai_variable_t buf = LAI_VAR_INITIALIZER;
+    test_eval_clone(&buf, "\\GBUF");
+    ((uint8_t *)lai_exec_buffer_access(&buf))[1] = 0x66;
+    LAI_CLEANUP_VAR lai_variable_t buf2 = LAI_VAR_INITIALIZER;
+    test_eval_clone(&buf2, "\\GBUF");
+    TEST_CHECK(((const uint8_t *)lai_exec_buffer_view(&buf))[1] == 0x66);
+    TEST_CHECK(((const uint8_t *)lai_exec_buffer_view(&buf2))[1] == 2);
+
+    LAI_CLEANUP_VAR lai_variable_t pkg = LAI_VAR_INITIALIZER;
+    test_eval_clone(&pkg, "\\GPKG");
+
+    // Same for copies made by Store() within AML, including nested packages.
+    TEST_CHECK(test_eval("\\CBUF", 0, NULL) == 0x155);
+    TEST_CHECK(test_eval("\\CPKG", 0, NULL) == 0x9721);
+    TEST_CHECK(test_eval("\\CPKG", 0, NULL) == 0x9721);
+    return test_finish();
+}
@@ -0,0 +1,86 @@
+/*
+ * Lightweight AML Interpreter
+ * Copyright (C) 2018-2023 The lai authors
+ */
+
+// Minimal host for the tests in this directory: memory comes from libc, warnings are counted
+// and there is no hardware behind I/O ports, memory or PCI.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <lai/host.h>
+
+#include "test.h"
+
+int test_failures;
+int test_warnings;
+size_t test_allocations;
+
+void *laihost_malloc(size_t size) {
+    test_allocations++;
+    return malloc(size ? size : 1);
+}
+
+void *laihost_realloc(void *ptr, size_t newsize, size_t oldsize) {
+    (void)oldsize;
+    test_allocations++;
+    return realloc(ptr, newsize ? newsize : 1);
+}
+
+void laihost_free(void *ptr, size_t size) {
+    (void)size;
+    free(ptr);
+}
+
+void laihost_log(int level, const char *msg) {
+    if (level != LAI_WARN_LOG)
+        return;
+    test_warnings++;
+    fprintf(stderr, "lai warning: %s\n", msg);
+}
+
+void laihost_panic(const char *msg) {
+    fprintf(stderr, "lai panic: %s\n", msg);
+    abort();
+}
+
+void test_load(const uint8_t *aml, size_t size) {
+    acpi_aml_t *table = calloc(1, sizeof(acpi_header_t) + size);
+    struct lai_aml_segment *amls = calloc(1, sizeof(struct lai_aml_segment));
+    if (!table || !amls)
+        abort();
+    memcpy(table->header.signature, "DSDT", 4);
+    table->header.length = sizeof(acpi_header_t) + size;
+    memcpy(table->data, aml, size);
+    amls->table = table;
+
+    if (!lai_ns_get_root())
+        lai_create_root();
+    LAI_CLEANUP_STATE lai_state_t state;
+    lai_init_state(&state);
+    TEST_CHECK(lai_populate(lai_ns_get_root(), amls, &state) == LAI_ERROR_NONE);
+}
+
+uint64_t test_eval(const char *path, int n, lai_variable_t *args) {
+    lai_nsnode_t *node = lai_resolve_path(NULL, path);
+    if (!node) {
+        fprintf(stderr, "%s does not exist\n", path);
+        test_failures++;
+        return 0;
+    }
+
+    LAI_CLEANUP_STATE lai_state_t state;
+    lai_init_state(&state);
+    LAI_CLEANUP_VAR lai_variable_t result = LAI_VAR_INITIALIZER;
+    uint64_t value = 0;
+    TEST_CHECK(lai_eval_args(&result, node, &state, n, args) == LAI_ERROR_NONE);
+    TEST_CHECK(lai_obj_get_integer(&result, &value) == LAI_ERROR_NONE);
+    return value;
+}
+
+int test_finish(void) {
+    if (test_failures)
+        fprintf(stderr, "%d checks failed\n", test_failures);
+    return test_failures ? 1 : 0;
+}
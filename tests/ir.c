@@ -0,0 +1,194 @@
+/*
+ * Lightweight AML Interpreter
+ * Copyright (C) 2018-2023 The lai authors
+ */
+
+// Methods evaluated on the IR (see lai_enable_ir()) return the same results as on the engine.
+
+#include <string.h>
+
+#include <lai/internal-exec.h>
+
+#include "../core/ir.h"
+#include "../core/ns_impl.h"
+#include "test.h"
+
+/*
+ * Name (IRNX, 5)
+ * Method (IRN1) { Return (IRNX + 1) }
+ * Method (IRN2) {
+ *     Local0 = IRNX
+ *     Return (Local0)
+ * }
+ * Method (ARIT, 2) {
+ *     Local0 = Arg0 + Arg1
+ *     Local1 = Local0 * 3
+ *     Return (Local1 - 1)
+ * }
+ * Method (LOOP, 1) {
+ *     Local0 = 0
+ *     Local1 = 0
+ *     While (Local0 < Arg0) {
+ *         Local0++
+ *         Local1 += Local0
+ *     }
+ *     Return (Local1)
+ * }
+ * Method (CND_, 1) {
+ *     If (Arg0 == 0) { Return (100) }
+ *     Else { Return (200) }
+ * }
+ * Method (RECU, 1) {
+ *     If (Arg0 == 0) { Return (0) }
+ *     Return (Arg0 + RECU (Arg0 - 1))
+ * }
+ * Method (SHFT, 1) { Return ((Arg0 << 4) | (Arg0 & 0xF)) }
+ * Name (GVAL, 0)
+ * Method (FUS1, 2) {
+ *     GVAL = Arg0 + Arg1
+ *     Local0 = GVAL * 2
+ *     Return (Local0)
+ * }
+ * Method (FUS2, 1) {
+ *     Local0 = 0
+ *     Local1 = 0
+ *     While (Local0 < Arg0) {
+ *         If ((Local0 > 2) && !(Local0 == 5)) { Local1 += Local0 }
+ *         Else {
+ *             If ((Local0 == 0) || (Local0 < 2)) { Local1++ }
+ *         }
+ *         Local0++
+ *     }
+ *     Return (Local1)
+ * }
+ * Method (FUS3, 1) { Arg0 = DerefOf (Arg0) + 4 }
+ * Method (FUS4, 1) {
+ *     Local0 = Arg0
+ *     FUS3 (RefOf (Local0))
+ *     Return (Local0)
+ * }
+ * Method (FUS5, 2) { Return (Arg0 + Arg1) }
+ */
+static const uint8_t aml[] = {
+    0x08, 0x49, 0x52, 0x4e, 0x58, 0x0a, 0x05, 0x14, 0x0e, 0x49, 0x52, 0x4e,
+    0x31, 0x00, 0xa4, 0x72, 0x49, 0x52, 0x4e, 0x58, 0x01, 0x00, 0x14, 0x0e,
+    0x49, 0x52, 0x4e, 0x32, 0x00, 0x70, 0x49, 0x52, 0x4e, 0x58, 0x60, 0xa4,
+    0x60, 0x14, 0x18, 0x41, 0x52, 0x49, 0x54, 0x02, 0x70, 0x72, 0x68, 0x69,
+    0x00, 0x60, 0x70, 0x77, 0x60, 0x0a, 0x03, 0x00, 0x61, 0xa4, 0x74, 0x61,
+    0x01, 0x00, 0x14, 0x19, 0x4c, 0x4f, 0x4f, 0x50, 0x01, 0x70, 0x00, 0x60,
+    0x70, 0x00, 0x61, 0xa2, 0x0a, 0x95, 0x60, 0x68, 0x75, 0x60, 0x72, 0x61,
+    0x60, 0x61, 0xa4, 0x61, 0x14, 0x13, 0x43, 0x4e, 0x44, 0x5f, 0x01, 0xa0,
+    0x07, 0x93, 0x68, 0x00, 0xa4, 0x0a, 0x64, 0xa1, 0x04, 0xa4, 0x0a, 0xc8,
+    0x14, 0x19, 0x52, 0x45, 0x43, 0x55, 0x01, 0xa0, 0x06, 0x93, 0x68, 0x00,
+    0xa4, 0x00, 0xa4, 0x72, 0x68, 0x52, 0x45, 0x43, 0x55, 0x74, 0x68, 0x01,
+    0x00, 0x00, 0x14, 0x13, 0x53, 0x48, 0x46, 0x54, 0x01, 0xa4, 0x7d, 0x79,
+    0x68, 0x0a, 0x04, 0x00, 0x7b, 0x68, 0x0a, 0x0f, 0x00, 0x00, 0x08, 0x47,
+    0x56, 0x41, 0x4c, 0x00, 0x14, 0x1b, 0x46, 0x55, 0x53, 0x31, 0x02, 0x70,
+    0x72, 0x68, 0x69, 0x00, 0x47, 0x56, 0x41, 0x4c, 0x70, 0x77, 0x47, 0x56,
+    0x41, 0x4c, 0x0a, 0x02, 0x00, 0x60, 0xa4, 0x60, 0x14, 0x33, 0x46, 0x55,
+    0x53, 0x32, 0x01, 0x70, 0x00, 0x60, 0x70, 0x00, 0x61, 0xa2, 0x24, 0x95,
+    0x60, 0x68, 0xa0, 0x0f, 0x90, 0x94, 0x60, 0x0a, 0x02, 0x92, 0x93, 0x60,
+    0x0a, 0x05, 0x72, 0x61, 0x60, 0x61, 0xa1, 0x0d, 0xa0, 0x0b, 0x91, 0x93,
+    0x60, 0x00, 0x95, 0x60, 0x0a, 0x02, 0x75, 0x61, 0x75, 0x60, 0xa4, 0x61,
+    0x14, 0x0c, 0x46, 0x55, 0x53, 0x33, 0x01, 0x72, 0x83, 0x68, 0x0a, 0x04,
+    0x68, 0x14, 0x11, 0x46, 0x55, 0x53, 0x34, 0x01, 0x70, 0x68, 0x60, 0x46,
+    0x55, 0x53, 0x33, 0x71, 0x60, 0xa4, 0x60, 0x14, 0x0b, 0x46, 0x55, 0x53,
+    0x35, 0x02, 0xa4, 0x72, 0x68, 0x69, 0x00,
+};
+
+static const struct {
+    const char *path;
+    int n;
+} methods[] = {
+    {"\\IRN1", 0}, {"\\IRN2", 0}, {"\\ARIT", 2}, {"\\LOOP", 1},
+    {"\\CND_", 1}, {"\\RECU", 1}, {"\\SHFT", 1}, {"\\FUS1", 2}, {"\\FUS2", 1},
+    {"\\FUS4", 1}, {"\\FUS5", 2},
+};
+
+static const uint64_t inputs[] = {0, 1, 7, 100, 0xFFFFFFFF, 0xFFFFFFFFFFFFFFFF};
+
+// Evaluates a method with the IR disabled and enabled and compares the results.
+static void test_compare(const char *path, int n, uint64_t arg0, uint64_t arg1) {
+    lai_variable_t args[2] = {{.type = LAI_INTEGER, .integer = arg0},
+                              {.type = LAI_INTEGER, .integer = arg1}};
+    lai_enable_ir(0);
+    uint64_t expected = test_eval(path, n, args);
+    lai_enable_ir(LAI_IR_ENABLE);
+    uint64_t result = test_eval(path, n, args);
+    if (result != expected) {
+        fprintf(stderr, "%s(0x%lx, 0x%lx): 0x%lx on the IR, 0x%lx on the engine\n", path,
+                (unsigned long)arg0, (unsigned long)arg1, (unsigned long)result,
+                (unsigned long)expected);
+        test_failures++;
+    }
+    TEST_CHECK(lai_resolve_path(NULL, path)->mth_ir);
+}
+
+static size_t test_num_insns(const char *path) {
+    return lai_ir_num_insns(lai_resolve_path(NULL, path)->mth_ir);
+}
+
+static int irnx_override(lai_variable_t *args, lai_variable_t *result) {
+    (void)args;
+    result->type = LAI_INTEGER;
+    result->integer = 41;
+    return 0;
+}
+
+int main(void) {
+    test_load(aml, sizeof(aml));
+
+    for (size_t i = 0; i < sizeof(methods) / sizeof(methods[0]); i++) {
+        for (size_t j = 0; j < sizeof(inputs) / sizeof(inputs[0]); j++) {
+            for (size_t k = 0; k < 3; k++) {
+                // LOOP, RECU and FUS2 iterate Arg0 times.
+                uint64_t arg0 = inputs[j];
+                if (arg0 > 100
+                    && (!strcmp(methods[i].path, "\\LOOP") || !strcmp(methods[i].path, "\\RECU")
+                        || !strcmp(methods[i].path, "\\FUS2")))
+                    continue;
+                test_compare(methods[i].path, methods[i].n, arg0, inputs[k]);
+            }
+        }
+    }
+
+    lai_variable_t arg = {.type = LAI_INTEGER, .integer = 8};
+    TEST_CHECK(test_eval("\\FUS2", 1, &arg) == 22);
+    TEST_CHECK(test_eval("\\FUS4", 1, &arg) == 12);
+
+    // Store (Add (...), X) and friends are fused into one instruction and ArgX, LocalX and
+    // constants are read directly by the operator (i.e., without load instructions).
+    TEST_CHECK(test_num_insns("\\ARIT") <= 4);
+    TEST_CHECK(test_num_insns("\\FUS1") <= 4);
+    TEST_CHECK(test_num_insns("\\FUS5") <= 2);
+
+    // LAI_IR_COMPARE runs pure methods on both engines and warns about differences.
+    lai_enable_ir(LAI_IR_ENABLE | LAI_IR_COMPARE);
+    for (size_t i = 0; i < sizeof(methods) / sizeof(methods[0]); i++) {
+        lai_variable_t args[2] = {{.type = LAI_INTEGER, .integer = 7},
+                                  {.type = LAI_INTEGER, .integer = 100}};
+        test_eval(methods[i].path, methods[i].n, args);
+    }
+    TEST_CHECK(!test_warnings);
+    lai_enable_ir(LAI_IR_ENABLE);
+
+    // Replace the Name IRNX by a method. Translations that read IRNX are stale now.
+    lai_nsnode_t *irnx = lai_resolve_path(NULL, "\\IRNX");
+    lai_uninstall_nsnode(irnx);
+    lai_nsnode_t *method = lai_create_nsnode_or_die();
+    method->type = LAI_NAMESPACE_METHOD;
+    memcpy(method->name, "IRNX", 4);
+    method->parent = lai_ns_get_root();
+    method->method_override = irnx_override;
+    TEST_CHECK(lai_install_nsnode(method) == LAI_ERROR_NONE);
+    TEST_CHECK(test_eval("\\IRN1", 0, NULL) == 42);
+    TEST_CHECK(test_eval("\\IRN2", 0, NULL) == 41);
+
+    lai_uninstall_nsnode(method);
+    TEST_CHECK(lai_install_nsnode(irnx) == LAI_ERROR_NONE);
+    TEST_CHECK(test_eval("\\IRN1", 0, NULL) == 6);
+    TEST_CHECK(test_eval("\\IRN2", 0, NULL) == 5);
+
+    TEST_CHECK(!test_warnings);
+    return test_finish();
+}
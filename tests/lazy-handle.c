@@ -0,0 +1,65 @@
+/*
+ * Lightweight AML Interpreter
+ * Copyright (C) 2018-2023 The lai authors
+ */
+
+// Compact objects: names in packages are stored as lazy handles (see lai_ns_resolve_lazy_handle()).
+
+#include "test.h"
+
+/*
+ * Device (DEV0) {
+ *     Name (PKG0, Package (2) {CHLD, \DEV0})
+ *     Device (CHLD) {}
+ * }
+ * Method (MKPK) {
+ *     Device (LDEV) {
+ *         Name (LPKG, Package (1) {\DEV0})
+ *     }
+ *     Return (LDEV.LPKG)
+ * }
+ */
+static const uint8_t aml[] = {
+    0x5b, 0x82, 0x1d, 0x44, 0x45, 0x56, 0x30, 0x08, 0x50, 0x4b, 0x47, 0x30,
+    0x12, 0x0b, 0x02, 0x43, 0x48, 0x4c, 0x44, 0x5c, 0x44, 0x45, 0x56, 0x30,
+    0x5b, 0x82, 0x05, 0x43, 0x48, 0x4c, 0x44, 0x14, 0x24, 0x4d, 0x4b, 0x50,
+    0x4b, 0x00, 0x5b, 0x82, 0x12, 0x4c, 0x44, 0x45, 0x56, 0x08, 0x4c, 0x50,
+    0x4b, 0x47, 0x12, 0x07, 0x01, 0x5c, 0x44, 0x45, 0x56, 0x30, 0xa4, 0x2e,
+    0x4c, 0x44, 0x45, 0x56, 0x4c, 0x50, 0x4b, 0x47,
+};
+
+static lai_nsnode_t *test_pkg_handle(lai_variable_t *pkg, size_t i) {
+    LAI_CLEANUP_VAR lai_variable_t element = LAI_VAR_INITIALIZER;
+    lai_nsnode_t *handle = NULL;
+    TEST_CHECK(lai_obj_get_pkg(pkg, i, &element) == LAI_ERROR_NONE);
+    TEST_CHECK(lai_obj_get_handle(&element, &handle) == LAI_ERROR_NONE);
+    return handle;
+}
+
+int main(void) {
+    test_load(aml, sizeof(aml));
+    TEST_CHECK(sizeof(lai_variable_t) == 16);
+
+    lai_nsnode_t *dev0 = lai_resolve_path(NULL, "\\DEV0");
+    LAI_CLEANUP_STATE lai_state_t state;
+    lai_init_state(&state);
+
+    // Relative names resolve from the scope of the package.
+    LAI_CLEANUP_VAR lai_variable_t pkg0 = LAI_VAR_INITIALIZER;
+    TEST_CHECK(lai_eval(&pkg0, lai_resolve_path(NULL, "\\DEV0.PKG0"), &state) == LAI_ERROR_NONE);
+    TEST_CHECK(test_pkg_handle(&pkg0, 0) == lai_resolve_path(NULL, "\\DEV0.CHLD"));
+    TEST_CHECK(test_pkg_handle(&pkg0, 1) == dev0);
+
+    // The scope of LPKG is gone once MKPK returns. Its entry in the lazy scope table is reused
+    // by the next invocation, while absolute names in the returned package still resolve.
+    size_t lazy_scopes_size = 0;
+    for (int i = 0; i < 8; i++) {
+        LAI_CLEANUP_VAR lai_variable_t pkg = LAI_VAR_INITIALIZER;
+        TEST_CHECK(lai_eval(&pkg, lai_resolve_path(NULL, "\\MKPK"), &state) == LAI_ERROR_NONE);
+        TEST_CHECK(test_pkg_handle(&pkg, 0) == dev0);
+        if (!i)
+            lazy_scopes_size = lai_current_instance()->lazy_scopes_size;
+        TEST_CHECK(lai_current_instance()->lazy_scopes_size == lazy_scopes_size);
+    }
+    return test_finish();
+}
@@ -0,0 +1,50 @@
+/*
+ * Lightweight AML Interpreter
+ * Copyright (C) 2018-2023 The lai authors
+ */
+
+// Method-local namespace nodes that are still referenced after the method returns.
+
+#include "test.h"
+
+/*
+ * Name (GNAM, Zero)
+ * Method (LRF1) {
+ *     Name (LNAM, 0x1234)
+ *     Return (RefOf (LNAM))
+ * }
+ * Method (LRF2) { Return (DerefOf (LRF1 ())) }
+ * Method (LRF3) {
+ *     Name (LNAM, 0x5678)
+ *     CopyObject (RefOf (LNAM), GNAM)
+ * }
+ * Method (LRF4) {
+ *     LRF3 ()
+ *     Return (DerefOf (GNAM))
+ * }
+ */
+static const uint8_t aml[] = {
+    0x08, 0x47, 0x4e, 0x41, 0x4d, 0x00, 0x14, 0x14, 0x4c, 0x52, 0x46, 0x31,
+    0x00, 0x08, 0x4c, 0x4e, 0x41, 0x4d, 0x0b, 0x34, 0x12, 0xa4, 0x71, 0x4c,
+    0x4e, 0x41, 0x4d, 0x14, 0x0c, 0x4c, 0x52, 0x46, 0x32, 0x00, 0xa4, 0x83,
+    0x4c, 0x52, 0x46, 0x31, 0x14, 0x18, 0x4c, 0x52, 0x46, 0x33, 0x00, 0x08,
+    0x4c, 0x4e, 0x41, 0x4d, 0x0b, 0x78, 0x56, 0x9d, 0x71, 0x4c, 0x4e, 0x41,
+    0x4d, 0x47, 0x4e, 0x41, 0x4d, 0x14, 0x10, 0x4c, 0x52, 0x46, 0x34, 0x00,
+    0x4c, 0x52, 0x46, 0x33, 0xa4, 0x83, 0x47, 0x4e, 0x41, 0x4d,
+};
+
+int main(void) {
+    test_load(aml, sizeof(aml));
+
+    // RefOf() of a method-local Name that escapes through Return().
+    TEST_CHECK(test_eval("\\LRF2", 0, NULL) == 0x1234);
+    TEST_CHECK(test_eval("\\LRF2", 0, NULL) == 0x1234);
+
+    // Same, but the reference is stored to a global Name.
+    TEST_CHECK(test_eval("\\LRF4", 0, NULL) == 0x5678);
+
+    // The local Names are still gone from the namespace.
+    TEST_CHECK(!lai_resolve_path(NULL, "\\LRF1.LNAM"));
+    TEST_CHECK(!lai_resolve_path(NULL, "\\LRF3.LNAM"));
+    return test_finish();
+}
@@ -0,0 +1,109 @@
+/*
+ * Lightweight AML Interpreter
+ * Copyright (C) 2018-2023 The lai authors
+ */
+
+// Operators with different operand modes (see core/ops.h). tests/meson.build also runs this
+// test against a library built with -DLAI_SWITCH_DISPATCH (per-opcode switch cases).
+
+#include "test.h"
+
+/*
+ * Name (GINT, 0x40)
+ * Name (GCPY, 0)
+ * Method (OP01) { Return (Not (0xFFFFFFFFFFFFFF00)) }
+ * Method (OP02) { Return ((FindSetLeftBit (0x80) << 8) | FindSetRightBit (0x80)) }
+ * Method (OP03) { Return (FromBCD (0x1234) + (ToBCD (7) << 16)) }
+ * Method (OP04) {
+ *     Divide (100, 7, Local0, Local1)
+ *     Return ((Local1 << 8) | Local0 | (Mod (100, 7) << 16))
+ * }
+ * Method (OP05) {
+ *     Return (Xor (0xF0, 0xFF) | ((Nand (0xF0, 0xFF) & 0xFF) << 8) | ((Nor (0, 0) & 0xF) << 16))
+ * }
+ * Method (OP06) {
+ *     Local0 = Concatenate ("ab", "cde")
+ *     Local1 = Mid (Local0, 1, 3)
+ *     Return ((SizeOf (Local0) << 8) | DerefOf (Index (ToBuffer (Local1), 0)))
+ * }
+ * Method (OP07) {
+ *     Local0 = Package (3) {1, 2, 3}
+ *     Local0[1] = 9
+ *     Return (DerefOf (Local0[1]) + SizeOf (Local0))
+ * }
+ * Method (OP08) {
+ *     Local0 = 5
+ *     Local0++
+ *     Local0++
+ *     Local0--
+ *     Return (Local0 + ToInteger ("0x10"))
+ * }
+ * Method (OP09) {
+ *     If (CondRefOf (GINT, Local1) && !CondRefOf (NOPE)) {
+ *         Local0 = RefOf (GINT)
+ *         Return (DerefOf (Local0) + ObjectType (GINT))
+ *     }
+ *     Return (0)
+ * }
+ * Method (OP10) {
+ *     Local0 = Package (4) {1, 5, 9, 5}
+ *     Return (Match (Local0, MEQ, 5, MTR, 0, 0) + Match (Local0, MEQ, 5, MTR, 0, 2))
+ * }
+ * Method (OP11) {
+ *     CopyObject (0x77, GCPY)
+ *     If (0 || (3 > 2)) { Return (GCPY + 1) }
+ *     Return (0)
+ * }
+ */
+static const uint8_t aml[] = {
+    0x08, 0x47, 0x49, 0x4e, 0x54, 0x0a, 0x40, 0x08, 0x47, 0x43, 0x50, 0x59,
+    0x00, 0x14, 0x12, 0x4f, 0x50, 0x30, 0x31, 0x00, 0xa4, 0x80, 0x0e, 0x00,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00, 0x14, 0x15, 0x4f, 0x50,
+    0x30, 0x32, 0x00, 0xa4, 0x7d, 0x79, 0x81, 0x0a, 0x80, 0x00, 0x0a, 0x08,
+    0x00, 0x82, 0x0a, 0x80, 0x00, 0x00, 0x14, 0x18, 0x4f, 0x50, 0x30, 0x33,
+    0x00, 0xa4, 0x72, 0x5b, 0x28, 0x0b, 0x34, 0x12, 0x00, 0x79, 0x5b, 0x29,
+    0x0a, 0x07, 0x00, 0x0a, 0x10, 0x00, 0x00, 0x14, 0x22, 0x4f, 0x50, 0x30,
+    0x34, 0x00, 0x78, 0x0a, 0x64, 0x0a, 0x07, 0x60, 0x61, 0xa4, 0x7d, 0x7d,
+    0x79, 0x61, 0x0a, 0x08, 0x00, 0x60, 0x00, 0x79, 0x85, 0x0a, 0x64, 0x0a,
+    0x07, 0x00, 0x0a, 0x10, 0x00, 0x00, 0x14, 0x2b, 0x4f, 0x50, 0x30, 0x35,
+    0x00, 0xa4, 0x7d, 0x7d, 0x7f, 0x0a, 0xf0, 0x0a, 0xff, 0x00, 0x79, 0x7b,
+    0x7c, 0x0a, 0xf0, 0x0a, 0xff, 0x00, 0x0a, 0xff, 0x00, 0x0a, 0x08, 0x00,
+    0x00, 0x79, 0x7b, 0x7e, 0x00, 0x00, 0x00, 0x0a, 0x0f, 0x00, 0x0a, 0x10,
+    0x00, 0x00, 0x14, 0x2b, 0x4f, 0x50, 0x30, 0x36, 0x00, 0x70, 0x73, 0x0d,
+    0x61, 0x62, 0x00, 0x0d, 0x63, 0x64, 0x65, 0x00, 0x00, 0x60, 0x70, 0x9e,
+    0x60, 0x01, 0x0a, 0x03, 0x00, 0x61, 0xa4, 0x7d, 0x79, 0x87, 0x60, 0x0a,
+    0x08, 0x00, 0x83, 0x88, 0x96, 0x61, 0x00, 0x00, 0x00, 0x00, 0x14, 0x21,
+    0x4f, 0x50, 0x30, 0x37, 0x00, 0x70, 0x12, 0x07, 0x03, 0x01, 0x0a, 0x02,
+    0x0a, 0x03, 0x60, 0x70, 0x0a, 0x09, 0x88, 0x60, 0x01, 0x00, 0xa4, 0x72,
+    0x83, 0x88, 0x60, 0x01, 0x00, 0x87, 0x60, 0x00, 0x14, 0x1c, 0x4f, 0x50,
+    0x30, 0x38, 0x00, 0x70, 0x0a, 0x05, 0x60, 0x75, 0x60, 0x75, 0x60, 0x76,
+    0x60, 0xa4, 0x72, 0x60, 0x99, 0x0d, 0x30, 0x78, 0x31, 0x30, 0x00, 0x00,
+    0x00, 0x14, 0x2b, 0x4f, 0x50, 0x30, 0x39, 0x00, 0xa0, 0x22, 0x90, 0x5b,
+    0x12, 0x47, 0x49, 0x4e, 0x54, 0x61, 0x92, 0x5b, 0x12, 0x4e, 0x4f, 0x50,
+    0x45, 0x00, 0x70, 0x71, 0x47, 0x49, 0x4e, 0x54, 0x60, 0xa4, 0x72, 0x83,
+    0x60, 0x8e, 0x47, 0x49, 0x4e, 0x54, 0x00, 0xa4, 0x00, 0x14, 0x26, 0x4f,
+    0x50, 0x31, 0x30, 0x00, 0x70, 0x12, 0x09, 0x04, 0x01, 0x0a, 0x05, 0x0a,
+    0x09, 0x0a, 0x05, 0x60, 0xa4, 0x72, 0x89, 0x60, 0x01, 0x0a, 0x05, 0x00,
+    0x00, 0x00, 0x89, 0x60, 0x01, 0x0a, 0x05, 0x00, 0x00, 0x0a, 0x02, 0x00,
+    0x14, 0x20, 0x4f, 0x50, 0x31, 0x31, 0x00, 0x9d, 0x0a, 0x77, 0x47, 0x43,
+    0x50, 0x59, 0xa0, 0x10, 0x91, 0x00, 0x94, 0x0a, 0x03, 0x0a, 0x02, 0xa4,
+    0x72, 0x47, 0x43, 0x50, 0x59, 0x01, 0x00, 0xa4, 0x00,
+};
+
+int main(void) {
+    test_load(aml, sizeof(aml));
+
+    TEST_CHECK(test_eval("\\OP01", 0, NULL) == 0xFF);
+    TEST_CHECK(test_eval("\\OP02", 0, NULL) == 0x808);
+    TEST_CHECK(test_eval("\\OP03", 0, NULL) == 0x704D2);
+    TEST_CHECK(test_eval("\\OP04", 0, NULL) == 0x20E02);
+    TEST_CHECK(test_eval("\\OP05", 0, NULL) == 0xF0F0F);
+    TEST_CHECK(test_eval("\\OP06", 0, NULL) == 0x562);
+    TEST_CHECK(test_eval("\\OP07", 0, NULL) == 12);
+    TEST_CHECK(test_eval("\\OP08", 0, NULL) == 0x16);
+    TEST_CHECK(test_eval("\\OP09", 0, NULL) == 0x41);
+    TEST_CHECK(test_eval("\\OP10", 0, NULL) == 4);
+    TEST_CHECK(test_eval("\\OP11", 0, NULL) == 0x78);
+    TEST_CHECK(!test_warnings);
+    return test_finish();
+}
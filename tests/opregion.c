@@ -0,0 +1,153 @@
+/*
+ * Lightweight AML Interpreter
+ * Copyright (C) 2018-2023 The lai authors
+ */
+
+// Fields in OperationRegions that are backed by address space handlers.
+
+#include <string.h>
+
+#include <lai/host.h>
+
+#include "test.h"
+
+/*
+ * OperationRegion (ECRG, EmbeddedControl, 0, 0x10)
+ * Field (ECRG, ByteAcc, NoLock, Preserve) { ECF0, 32 }
+ * Method (ECRD) {
+ *     Local0 = ECF0
+ *     Local1 = ECF0
+ *     ECF0 = Local0
+ *     Return (Local0 + Local1)
+ * }
+ *
+ * OperationRegion (OEMR, 0x80, 0, 0x10)
+ * Field (OEMR, DWordAcc, NoLock, Preserve) { OEMD, 32 }
+ * Field (OEMR, ByteAcc, NoLock, Preserve) { Offset (4), OEMB, 32 }
+ * Method (ORDD) { Return (OEMD) }
+ * Method (ORDB) { Return (OEMB) }
+ * Method (OWRD) { OEMD = 0x12345678 }
+ * Method (OWRB) { OEMB = 0x9ABCDEF0 }
+ */
+static const uint8_t aml[] = {
+    0x5b, 0x80, 0x45, 0x43, 0x52, 0x47, 0x03, 0x00, 0x0a, 0x10, 0x5b, 0x81,
+    0x0b, 0x45, 0x43, 0x52, 0x47, 0x01, 0x45, 0x43, 0x46, 0x30, 0x20, 0x14,
+    0x1d, 0x45, 0x43, 0x52, 0x44, 0x00, 0x70, 0x45, 0x43, 0x46, 0x30, 0x60,
+    0x70, 0x45, 0x43, 0x46, 0x30, 0x61, 0x70, 0x60, 0x45, 0x43, 0x46, 0x30,
+    0xa4, 0x72, 0x60, 0x61, 0x00, 0x5b, 0x80, 0x4f, 0x45, 0x4d, 0x52, 0x80,
+    0x00, 0x0a, 0x10, 0x5b, 0x81, 0x0b, 0x4f, 0x45, 0x4d, 0x52, 0x03, 0x4f,
+    0x45, 0x4d, 0x44, 0x20, 0x5b, 0x81, 0x0d, 0x4f, 0x45, 0x4d, 0x52, 0x01,
+    0x00, 0x20, 0x4f, 0x45, 0x4d, 0x42, 0x20, 0x14, 0x0b, 0x4f, 0x52, 0x44,
+    0x44, 0x00, 0xa4, 0x4f, 0x45, 0x4d, 0x44, 0x14, 0x0b, 0x4f, 0x52, 0x44,
+    0x42, 0x00, 0xa4, 0x4f, 0x45, 0x4d, 0x42, 0x14, 0x10, 0x4f, 0x57, 0x52,
+    0x44, 0x00, 0x70, 0x0c, 0x78, 0x56, 0x34, 0x12, 0x4f, 0x45, 0x4d, 0x44,
+    0x14, 0x10, 0x4f, 0x57, 0x52, 0x42, 0x00, 0x70, 0x0c, 0xf0, 0xde, 0xbc,
+    0x9a, 0x4f, 0x45, 0x4d, 0x42,
+};
+
+static uint8_t ec_readb(uint64_t address, void *userptr) {
+    (void)address;
+    (void)userptr;
+    return 0x11;
+}
+
+static void ec_writeb(uint64_t address, uint8_t value, void *userptr) {
+    (void)address;
+    (void)value;
+    (void)userptr;
+}
+
+static const struct lai_opregion_override ec_ops = {
+    .readb = ec_readb,
+    .writeb = ec_writeb,
+};
+
+// Counts the accesses of each width; bulk accesses count as width zero.
+static uint8_t oem_data[0x10];
+static int oem_accesses[9];
+
+static uint8_t oem_readb(uint64_t address, void *userptr) {
+    (void)userptr;
+    oem_accesses[1]++;
+    return oem_data[address];
+}
+
+static uint32_t oem_readd(uint64_t address, void *userptr) {
+    (void)userptr;
+    oem_accesses[4]++;
+    uint32_t value;
+    memcpy(&value, &oem_data[address], 4);
+    return value;
+}
+
+static void oem_writeb(uint64_t address, uint8_t value, void *userptr) {
+    (void)userptr;
+    oem_accesses[1]++;
+    oem_data[address] = value;
+}
+
+static void oem_writed(uint64_t address, uint32_t value, void *userptr) {
+    (void)userptr;
+    oem_accesses[4]++;
+    memcpy(&oem_data[address], &value, 4);
+}
+
+static void oem_read_bulk(uint64_t address, void *buffer, size_t size, void *userptr) {
+    (void)userptr;
+    oem_accesses[0]++;
+    memcpy(buffer, &oem_data[address], size);
+}
+
+static void oem_write_bulk(uint64_t address, const void *buffer, size_t size, void *userptr) {
+    (void)userptr;
+    oem_accesses[0]++;
+    memcpy(&oem_data[address], buffer, size);
+}
+
+static const struct lai_opregion_override oem_ops = {
+    .readb = oem_readb,
+    .readd = oem_readd,
+    .writeb = oem_writeb,
+    .writed = oem_writed,
+    .read_bulk = oem_read_bulk,
+    .write_bulk = oem_write_bulk,
+};
+
+// Bulk callbacks transfer bytes. Fields that require wider accesses must not use them.
+static void test_bulk_access_width(void) {
+    TEST_CHECK(!lai_install_address_space_handler(0x80, &oem_ops, NULL));
+
+    TEST_CHECK(test_eval("\\OWRD", 0, NULL) == 0);
+    TEST_CHECK(test_eval("\\ORDD", 0, NULL) == 0x12345678);
+    TEST_CHECK(oem_accesses[4] && !oem_accesses[0] && !oem_accesses[1]);
+
+    int dword_accesses = oem_accesses[4];
+    TEST_CHECK(test_eval("\\OWRB", 0, NULL) == 0);
+    TEST_CHECK(test_eval("\\ORDB", 0, NULL) == 0x9ABCDEF0);
+    TEST_CHECK(oem_accesses[4] == dword_accesses && oem_accesses[0] == 2 && !oem_accesses[1]);
+}
+
+// Accesses without a handler read as zero. They are reported once per address space,
+// not once per access unit.
+static void test_missing_handler(void) {
+    int warnings = test_warnings;
+    TEST_CHECK(test_eval("\\ECRD", 0, NULL) == 0);
+    TEST_CHECK(test_eval("\\ECRD", 0, NULL) == 0);
+    TEST_CHECK(test_warnings == warnings + 1);
+
+    TEST_CHECK(!lai_install_address_space_handler(ACPI_OPREGION_EC, &ec_ops, NULL));
+    TEST_CHECK(test_eval("\\ECRD", 0, NULL) == 2 * 0x11111111);
+    TEST_CHECK(test_warnings == warnings + 1);
+
+    // Once the handler is gone, this is reported again.
+    TEST_CHECK(!lai_install_address_space_handler(ACPI_OPREGION_EC, NULL, NULL));
+    TEST_CHECK(test_eval("\\ECRD", 0, NULL) == 0);
+    TEST_CHECK(test_warnings == warnings + 2);
+}
+
+int main(void) {
+    test_load(aml, sizeof(aml));
+    test_missing_handler();
+    test_bulk_access_width();
+    return test_finish();
+}
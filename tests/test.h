@@ -0,0 +1,36 @@
+/*
+ * Lightweight AML Interpreter
+ * Copyright (C) 2018-2023 The lai authors
+ */
+
+// Helpers for the tests in this directory (see host.c).
+// The ASL test suite that runs on full ACPI tables lives in lai_tools.
+
+#pragma once
+
+#include <stdio.h>
+
+#include <lai/core.h>
+
+#define TEST_CHECK(cond)                                                                           \
+    do {                                                                                           \
+        if (!(cond)) {                                                                             \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);               \
+            test_failures++;                                                                       \
+        }                                                                                          \
+    } while (0)
+
+extern int test_failures;
+// Number of calls to laihost_log() with LAI_WARN_LOG.
+extern int test_warnings;
+// Number of calls to laihost_malloc() and laihost_realloc().
+extern size_t test_allocations;
+
+// Loads AML (without table header) into the namespace. Creates the namespace root on first use.
+void test_load(const uint8_t *aml, size_t size);
+
+// Evaluates a node by its absolute path and returns the resulting integer.
+uint64_t test_eval(const char *path, int n, lai_variable_t *args);
+
+// Returns the exit status of a test.
+int test_finish(void);